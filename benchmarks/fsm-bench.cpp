@@ -0,0 +1,264 @@
+#include <benchmark/benchmark.h>
+
+#include <fsm/lexer.hpp>
+#include <fsm/lexer_spec.hpp>
+
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#elif defined(__unix__)
+#include <unistd.h>
+#endif
+
+namespace
+{
+constexpr std::int64_t kilobyte = 1 << 10;
+constexpr std::int64_t megabyte = 1 << 20;
+constexpr std::int64_t gigabyte = 1 << 30;
+
+// std::regex lexes well under 1 MB/s, so its largest corpus is kept small enough to finish.
+constexpr std::int64_t std_regex_max_size = megabyte;
+
+constexpr std::size_t token_buffer_capacity = 64 * 1024;
+
+// Resident set size right now, not the process peak, so each benchmark can report its own growth.
+double current_rss_mb()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters{};
+	::GetProcessMemoryInfo(::GetCurrentProcess(), &counters, sizeof(counters));
+	return static_cast<double>(counters.WorkingSetSize) / megabyte;
+#elif defined(__APPLE__)
+	mach_task_basic_info info{};
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+	::task_info(::mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count);
+	return static_cast<double>(info.resident_size) / megabyte;
+#elif defined(__unix__)
+	std::ifstream statm("/proc/self/statm");
+	std::size_t total_pages = 0;
+	std::size_t resident_pages = 0;
+	statm >> total_pages >> resident_pages;
+	return static_cast<double>(resident_pages) * static_cast<double>(::sysconf(_SC_PAGESIZE)) / megabyte;
+#else
+	return 0.0;
+#endif
+}
+
+std::vector<fsm::lexer_spec_entry> const& lang_spec()
+{
+	static const auto entries = [] {
+		std::ifstream file(FSM_BENCH_RES_DIR "/lang_grammar.txt");
+		if (!file.is_open())
+		{
+			throw std::runtime_error("Could not open " FSM_BENCH_RES_DIR "/lang_grammar.txt");
+		}
+
+		return fsm::lexer_spec_parse(file);
+	}();
+
+	return entries;
+}
+
+template <typename T_Matcher>
+std::vector<typename fsm::lexer<std::string, T_Matcher>::rule> lang_rules()
+{
+	std::vector<typename fsm::lexer<std::string, T_Matcher>::rule> rules;
+	for (auto const& entry : lang_spec())
+	{
+		rules.push_back({ entry.name, T_Matcher::compile(entry.pattern), entry.skip });
+	}
+
+	return rules;
+}
+
+/**
+ * A program of the `lang_src.txt` language of about `size` bytes: declarations
+ * followed by arithmetic assignments over random identifiers and numbers. The
+ * generator is seeded, so every run lexes the same text.
+ */
+std::string make_corpus(const std::size_t size)
+{
+	static const std::vector<std::string> names = { "a", "b", "x", "count", "total_sum", "const_val", "delta2", "Item_42" };
+	static const std::vector<std::string> operators = { " + ", " - ", " * ", " / " };
+
+	std::mt19937 random(42);
+	const auto pick = [&](std::vector<std::string> const& items) -> std::string const& {
+		return items[random() % items.size()];
+	};
+	const auto number = [&] {
+		std::string text = std::to_string(random() % 10000);
+		if (random() % 3 == 0)
+		{
+			text += "." + std::to_string(random() % 100);
+		}
+
+		return text;
+	};
+
+	std::string corpus = "main\n    var a, b : int;\n    var x : float;\nbegin\n";
+	corpus.reserve(size + 64);
+	while (corpus.size() < size)
+	{
+		corpus += "    " + pick(names) + " = ";
+		const auto terms = 1 + random() % 4;
+		for (std::size_t i = 0; i < terms; ++i)
+		{
+			if (i != 0)
+			{
+				corpus += pick(operators);
+			}
+			corpus += random() % 2 == 0 ? pick(names) : number();
+		}
+		corpus += random() % 5 == 0 ? ";\n\n" : ";\n";
+	}
+	corpus += "end.";
+
+	return corpus;
+}
+
+template <typename T_Matcher>
+void BM_Tokenize(benchmark::State& state)
+{
+	const double rss_before = current_rss_mb();
+
+	// Built per run and freed on return, so a large corpus does not stay resident for later benchmarks.
+	const std::string source = make_corpus(static_cast<std::size_t>(state.range(0)));
+	fsm::lexer<std::string, T_Matcher> lex(source, lang_rules<T_Matcher>());
+	if constexpr (fsm::concepts::combined_matcher<T_Matcher>)
+	{
+		benchmark::DoNotOptimize(&lex.engine());
+	}
+
+	fsm::token_buffer<std::string> buffer(token_buffer_capacity);
+	std::size_t tokens = 0;
+	for (auto _ : state)
+	{
+		lex.change_source(source);
+		buffer.clear();
+
+		const auto count = lex.tokenize_into(buffer, [](fsm::token_buffer<std::string>& full) {
+			benchmark::DoNotOptimize(full.types().data());
+		});
+		if (!count)
+		{
+			state.SkipWithError(count.error().to_string().c_str());
+			return;
+		}
+		tokens = *count;
+		benchmark::DoNotOptimize(tokens);
+	}
+
+	state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(source.size()));
+	state.counters["tokens/s"] = benchmark::Counter(
+		static_cast<double>(tokens),
+		benchmark::Counter::kIsIterationInvariantRate);
+	state.counters["rss_growth_mb"] = current_rss_mb() - rss_before;
+}
+
+// Compile phases of one rule set, as fsm_regex_matcher::compile runs them.
+void BM_CompileParse(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		for (auto const& entry : lang_spec())
+		{
+			benchmark::DoNotOptimize(fsm::details::regex_parser{}(entry.pattern));
+		}
+	}
+}
+
+void BM_CompileNfa(benchmark::State& state)
+{
+	std::vector<fsm::details::regex_parser::ast> trees;
+	for (auto const& entry : lang_spec())
+	{
+		trees.push_back(fsm::details::regex_parser{}(entry.pattern));
+	}
+
+	for (auto _ : state)
+	{
+		for (auto const& tree : trees)
+		{
+			benchmark::DoNotOptimize(fsm::details::regex_builder{}(tree));
+		}
+	}
+}
+
+void BM_CompileDfa(benchmark::State& state)
+{
+	std::vector<fsm::recognizer_state> nfas;
+	for (auto const& entry : lang_spec())
+	{
+		nfas.push_back(fsm::details::regex_builder{}(fsm::details::regex_parser{}(entry.pattern)));
+	}
+
+	for (auto _ : state)
+	{
+		for (auto const& nfa : nfas)
+		{
+			fsm::details::byte_dfa_compiler::final_tags_type final_tags;
+			for (auto const& final_id : nfa.final_state_ids)
+			{
+				final_tags.emplace(final_id, 0);
+			}
+
+			benchmark::DoNotOptimize(fsm::details::byte_dfa_compiler{}(nfa, final_tags, [](auto const&) { return 1; }));
+		}
+	}
+}
+
+template <typename T_Matcher>
+void BM_CompileRules(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(lang_rules<T_Matcher>());
+	}
+}
+
+void BM_CompileCombinedEngine(benchmark::State& state)
+{
+	const auto rules = lang_rules<fsm::combined_dfa_matcher>();
+	for (auto _ : state)
+	{
+		fsm::lexer<std::string, fsm::combined_dfa_matcher> lex("", rules);
+		benchmark::DoNotOptimize(&lex.engine());
+	}
+}
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Tokenize, fsm::fsm_regex_matcher)
+	->RangeMultiplier(32)
+	->Range(kilobyte, gigabyte)
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Tokenize, fsm::combined_dfa_matcher)
+	->RangeMultiplier(32)
+	->Range(kilobyte, gigabyte)
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Tokenize, fsm::std_regex_matcher)
+	->RangeMultiplier(32)
+	->Range(kilobyte, std_regex_max_size)
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
+
+BENCHMARK(BM_CompileParse)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CompileNfa)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CompileDfa)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_CompileRules, fsm::fsm_regex_matcher)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_CompileRules, fsm::std_regex_matcher)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CompileCombinedEngine)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,41 @@
+# fsm_generate_scanner(<target>
+#         SPEC <rule file>
+#         OUTPUT <header>
+#         [CLASS <class name>]
+#         [NAMESPACE <namespace>])
+#
+# Generates a direct-coded scanner header from a lexer rule file at build time
+# and adds its directory to the include path of <target>.
+function(fsm_generate_scanner target)
+    cmake_parse_arguments(ARG "" "SPEC;OUTPUT;CLASS;NAMESPACE" "" ${ARGN})
+
+    if (NOT TARGET fsm-scannergen)
+        message(FATAL_ERROR "fsm_generate_scanner requires the fsm-scannergen tool (FSM_BUILD_TOOLS=ON)")
+    endif ()
+    if (NOT ARG_SPEC OR NOT ARG_OUTPUT)
+        message(FATAL_ERROR "fsm_generate_scanner requires SPEC and OUTPUT")
+    endif ()
+
+    set(options)
+    if (ARG_CLASS)
+        list(APPEND options --class ${ARG_CLASS})
+    endif ()
+    if (ARG_NAMESPACE)
+        list(APPEND options --namespace ${ARG_NAMESPACE})
+    endif ()
+
+    get_filename_component(spec "${ARG_SPEC}" ABSOLUTE)
+    get_filename_component(output "${ARG_OUTPUT}" ABSOLUTE BASE_DIR "${CMAKE_CURRENT_BINARY_DIR}")
+    get_filename_component(output_dir "${output}" DIRECTORY)
+
+    add_custom_command(
+            OUTPUT "${output}"
+            COMMAND fsm-scannergen "${spec}" "${output}" ${options}
+            DEPENDS fsm-scannergen "${spec}"
+            COMMENT "Generating scanner ${output}"
+            VERBATIM
+    )
+
+    target_sources(${target} PRIVATE "${output}")
+    target_include_directories(${target} PRIVATE "${output_dir}")
+endfunction()
@@ -0,0 +1,412 @@
+#ifndef FSM_BYTE_DFA_HPP
+#define FSM_BYTE_DFA_HPP
+
+#include "recognizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fsm
+{
+/**
+ * @brief Non-owning view of `byte_dfa` tables, e.g. ones living in mapped memory.
+ */
+struct byte_dfa_view
+{
+	using state_type = std::uint32_t;
+	using tag_type = std::uint32_t;
+
+	const std::uint8_t* byte_classes = nullptr;
+	std::uint32_t class_count = 1;
+	const state_type* transitions = nullptr;
+	const tag_type* accept_tags = nullptr;
+	std::size_t states = 0;
+	state_type start_state = 0;
+
+	[[nodiscard]] state_type next(const state_type state, const unsigned char byte) const
+	{
+		return transitions[state * class_count + byte_classes[byte]];
+	}
+
+	[[nodiscard]] tag_type accept_tag(const state_type state) const
+	{
+		return accept_tags[state];
+	}
+
+	[[nodiscard]] std::size_t state_count() const
+	{
+		return states;
+	}
+};
+
+/**
+ * @brief A deterministic automaton over bytes stored as flat integer tables.
+ *
+ * Bytes are first mapped to equivalence classes, so a transition is a single
+ * load from `transitions[state * class_count + byte_classes[byte]]`. State 0 is
+ * the dead state: it loops onto itself and is never accepting. Every state
+ * carries an accept tag, 0 meaning "not accepting"; what a non-zero tag stands
+ * for (a pattern set, a lexer rule, ...) is up to the owner of the table.
+ */
+struct byte_dfa
+{
+	using state_type = std::uint32_t;
+	using tag_type = std::uint32_t;
+
+	static constexpr state_type dead_state = 0;
+	static constexpr tag_type no_tag = 0;
+
+	std::array<std::uint8_t, 256> byte_classes{};
+	std::uint32_t class_count = 1;
+	std::vector<state_type> transitions = { dead_state };
+	std::vector<tag_type> accept_tags = { no_tag };
+	state_type start_state = dead_state;
+
+	[[nodiscard]] state_type next(const state_type state, const unsigned char byte) const
+	{
+		return transitions[state * class_count + byte_classes[byte]];
+	}
+
+	[[nodiscard]] tag_type accept_tag(const state_type state) const
+	{
+		return accept_tags[state];
+	}
+
+	[[nodiscard]] std::size_t state_count() const
+	{
+		return accept_tags.size();
+	}
+
+	[[nodiscard]] byte_dfa_view view() const
+	{
+		return { byte_classes.data(), class_count, transitions.data(), accept_tags.data(), accept_tags.size(), start_state };
+	}
+};
+
+namespace details
+{
+class byte_dfa_compiler
+{
+	using row_t = std::array<byte_dfa::state_type, 256>;
+	using tag_set_t = std::vector<std::uint32_t>;
+
+public:
+	using final_tags_type = std::map<recognizer_state::state_id, std::uint32_t>;
+
+	/**
+	 * @param nfa A recognizer state whose inputs are single bytes or epsilon.
+	 * @param final_tags Tag of every accepting NFA state the result should know about.
+	 * @param resolve Maps the sorted tags of a DFA state onto its accept tag.
+	 */
+	template <typename T_Resolve>
+	byte_dfa operator()(recognizer_state const& nfa, final_tags_type const& final_tags, T_Resolve&& resolve)
+	{
+		index_nfa(nfa, final_tags);
+		determinize(resolve);
+		minimize();
+
+		return make_table();
+	}
+
+private:
+	std::vector<std::vector<std::uint32_t>> m_epsilon;
+	std::vector<std::vector<std::pair<unsigned char, std::uint32_t>>> m_edges;
+	std::vector<std::vector<std::uint32_t>> m_nfa_tags;
+	std::uint32_t m_nfa_start = 0;
+
+	std::vector<std::uint32_t> m_visit_stamp;
+	std::uint32_t m_stamp = 0;
+	std::vector<std::vector<std::uint32_t>> m_closures;
+
+	std::vector<row_t> m_rows;
+	std::vector<byte_dfa::tag_type> m_tags;
+	byte_dfa::state_type m_start = byte_dfa::dead_state;
+
+	void index_nfa(recognizer_state const& nfa, final_tags_type const& final_tags)
+	{
+		std::map<recognizer_state::state_id, std::uint32_t> index;
+		for (auto const& id : nfa.state_ids)
+		{
+			index.emplace(id, static_cast<std::uint32_t>(index.size()));
+		}
+
+		m_epsilon.assign(index.size(), {});
+		m_edges.assign(index.size(), {});
+		m_nfa_tags.assign(index.size(), {});
+		m_visit_stamp.assign(index.size(), 0);
+		m_nfa_start = index.at(nfa.initial_state_id);
+
+		for (auto const& [key, to] : nfa.transitions)
+		{
+			auto const& [from, input] = key;
+			if (!input.has_value())
+			{
+				m_epsilon[index.at(from)].push_back(index.at(to));
+			}
+			else if (input->size() == 1)
+			{
+				m_edges[index.at(from)].emplace_back(static_cast<unsigned char>(input->front()), index.at(to));
+			}
+			else
+			{
+				throw std::invalid_argument("byte_dfa: transition input '" + *input + "' is not a single byte");
+			}
+		}
+
+		for (auto const& [id, tag] : final_tags)
+		{
+			if (nfa.final_state_ids.contains(id))
+			{
+				m_nfa_tags[index.at(id)].push_back(tag);
+			}
+		}
+
+		m_closures.resize(index.size());
+		for (std::uint32_t state = 0; state < index.size(); ++state)
+		{
+			m_closures[state] = epsilon_closure(state);
+		}
+	}
+
+	std::vector<std::uint32_t> epsilon_closure(const std::uint32_t seed)
+	{
+		++m_stamp;
+
+		std::vector<std::uint32_t> result;
+		std::vector<std::uint32_t> stack = { seed };
+		while (!stack.empty())
+		{
+			const auto state = stack.back();
+			stack.pop_back();
+			if (m_visit_stamp[state] == m_stamp)
+			{
+				continue;
+			}
+
+			m_visit_stamp[state] = m_stamp;
+			result.push_back(state);
+			stack.insert(stack.end(), m_epsilon[state].begin(), m_epsilon[state].end());
+		}
+
+		std::ranges::sort(result);
+
+		return result;
+	}
+
+	// Most buckets hold a single NFA state, whose closure is already known.
+	std::vector<std::uint32_t> closure_of(std::vector<std::uint32_t> const& seeds) const
+	{
+		if (seeds.size() == 1)
+		{
+			return m_closures[seeds.front()];
+		}
+
+		std::vector<std::uint32_t> result;
+		for (const auto seed : seeds)
+		{
+			result.insert(result.end(), m_closures[seed].begin(), m_closures[seed].end());
+		}
+
+		std::ranges::sort(result);
+		result.erase(std::ranges::unique(result).begin(), result.end());
+
+		return result;
+	}
+
+	template <typename T_Resolve>
+	void determinize(T_Resolve& resolve)
+	{
+		std::map<std::vector<std::uint32_t>, byte_dfa::state_type> ids;
+		std::vector<std::vector<std::uint32_t>> sets;
+
+		auto intern = [&](std::vector<std::uint32_t> set) {
+			auto [it, inserted] = ids.try_emplace(set, static_cast<byte_dfa::state_type>(sets.size()));
+			if (inserted)
+			{
+				sets.push_back(std::move(set));
+			}
+			return it->second;
+		};
+
+		intern({});
+		m_start = intern(m_closures[m_nfa_start]);
+
+		std::array<std::vector<std::uint32_t>, 256> buckets;
+		for (std::size_t current = 0; current < sets.size(); ++current)
+		{
+			for (auto& bucket : buckets)
+			{
+				bucket.clear();
+			}
+
+			tag_set_t tags;
+			for (const auto state : sets[current])
+			{
+				for (auto const& [byte, to] : m_edges[state])
+				{
+					buckets[byte].push_back(to);
+				}
+				tags.insert(tags.end(), m_nfa_tags[state].begin(), m_nfa_tags[state].end());
+			}
+
+			std::ranges::sort(tags);
+			tags.erase(std::ranges::unique(tags).begin(), tags.end());
+			m_tags.push_back(tags.empty() ? byte_dfa::no_tag : static_cast<byte_dfa::tag_type>(resolve(tags)));
+
+			row_t row{};
+			for (std::size_t byte = 0; byte < buckets.size(); ++byte)
+			{
+				row[byte] = buckets[byte].empty()
+					? byte_dfa::dead_state
+					: intern(closure_of(buckets[byte]));
+			}
+			m_rows.push_back(row);
+		}
+	}
+
+	struct byte_partition
+	{
+		std::array<std::uint8_t, 256> classes{};
+		std::vector<std::uint8_t> representatives;
+	};
+
+	static byte_partition partition_bytes(std::vector<row_t> const& rows)
+	{
+		byte_partition partition;
+		std::map<std::vector<byte_dfa::state_type>, std::uint8_t> columns;
+		for (std::size_t byte = 0; byte < 256; ++byte)
+		{
+			std::vector<byte_dfa::state_type> column;
+			column.reserve(rows.size());
+			for (auto const& row : rows)
+			{
+				column.push_back(row[byte]);
+			}
+
+			const auto next_class = static_cast<std::uint8_t>(partition.representatives.size());
+			auto [it, inserted] = columns.try_emplace(std::move(column), next_class);
+			if (inserted)
+			{
+				partition.representatives.push_back(static_cast<std::uint8_t>(byte));
+			}
+			partition.classes[byte] = it->second;
+		}
+
+		return partition;
+	}
+
+	void minimize()
+	{
+		const auto bytes = partition_bytes(m_rows).representatives;
+
+		std::vector<std::uint32_t> block(m_rows.size());
+		std::size_t block_count = 0;
+		{
+			std::map<byte_dfa::tag_type, std::uint32_t> by_tag;
+			for (std::size_t state = 0; state < m_rows.size(); ++state)
+			{
+				block[state] = by_tag.try_emplace(m_tags[state], static_cast<std::uint32_t>(by_tag.size())).first->second;
+			}
+			block_count = by_tag.size();
+		}
+
+		while (true)
+		{
+			std::map<std::vector<std::uint32_t>, std::uint32_t> signatures;
+			std::vector<std::uint32_t> next_block(m_rows.size());
+
+			for (std::size_t state = 0; state < m_rows.size(); ++state)
+			{
+				std::vector<std::uint32_t> signature;
+				signature.reserve(bytes.size() + 1);
+				signature.push_back(block[state]);
+				for (const auto byte : bytes)
+				{
+					signature.push_back(block[m_rows[state][byte]]);
+				}
+
+				next_block[state] = signatures.try_emplace(std::move(signature), static_cast<std::uint32_t>(signatures.size())).first->second;
+			}
+
+			block = std::move(next_block);
+			if (signatures.size() == block_count)
+			{
+				break;
+			}
+			block_count = signatures.size();
+		}
+
+		// Renumber blocks breadth-first from the start state, keeping the dead block at 0.
+		constexpr auto unassigned = static_cast<byte_dfa::state_type>(-1);
+		std::vector<byte_dfa::state_type> renumber(block_count, unassigned);
+		std::vector<std::size_t> representative;
+
+		renumber[block[byte_dfa::dead_state]] = byte_dfa::dead_state;
+		representative.push_back(byte_dfa::dead_state);
+
+		auto assign = [&](const std::size_t state) {
+			if (renumber[block[state]] == unassigned)
+			{
+				renumber[block[state]] = static_cast<byte_dfa::state_type>(representative.size());
+				representative.push_back(state);
+			}
+		};
+
+		assign(m_start);
+		for (std::size_t i = 1; i < representative.size(); ++i)
+		{
+			for (const auto to : m_rows[representative[i]])
+			{
+				assign(to);
+			}
+		}
+
+		std::vector<row_t> rows(representative.size());
+		std::vector<byte_dfa::tag_type> tags(representative.size());
+		for (std::size_t i = 0; i < representative.size(); ++i)
+		{
+			for (std::size_t byte = 0; byte < 256; ++byte)
+			{
+				rows[i][byte] = renumber[block[m_rows[representative[i]][byte]]];
+			}
+			tags[i] = m_tags[representative[i]];
+		}
+
+		m_start = renumber[block[m_start]];
+		m_rows = std::move(rows);
+		m_tags = std::move(tags);
+	}
+
+	byte_dfa make_table() const
+	{
+		byte_dfa dfa;
+
+		const auto [classes, bytes] = partition_bytes(m_rows);
+		dfa.byte_classes = classes;
+		dfa.class_count = static_cast<std::uint32_t>(bytes.size());
+
+		dfa.transitions.resize(m_rows.size() * dfa.class_count);
+		for (std::size_t state = 0; state < m_rows.size(); ++state)
+		{
+			for (std::size_t cls = 0; cls < bytes.size(); ++cls)
+			{
+				dfa.transitions[state * dfa.class_count + cls] = m_rows[state][bytes[cls]];
+			}
+		}
+
+		dfa.accept_tags = m_tags;
+		dfa.start_state = m_start;
+
+		return dfa;
+	}
+};
+} // namespace details
+
+} // namespace fsm
+
+#endif // FSM_BYTE_DFA_HPP
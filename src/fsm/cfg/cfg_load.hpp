@@ -2,6 +2,7 @@
 #define FSM_LOAD_CFG_HPP
 
 #include "../concepts.hpp"
+#include "../mapped_source.hpp"
 #include "../utility.hpp"
 #include "basic_cfg.hpp"
 
@@ -117,6 +118,16 @@ cfg_load(std::istream& in = std::cin)
 
 	return grammar_type{ non_terminals, terminals, rules, start };
 }
+
+template <
+	concepts::is_std_string_constructible T_Symbol = std::string,
+	typename T_Compare = std::less<T_Symbol>>
+basic_cfg<T_Symbol, T_Compare>
+cfg_load(mapped_source const& source)
+{
+	auto in = source.stream();
+	return cfg_load<T_Symbol, T_Compare>(in);
+}
 } // namespace fsm
 
 #endif // FSM_LOAD_CFG_HPP
\ No newline at end of file
@@ -6,6 +6,7 @@
 
 #include <concepts>
 #include <ranges>
+#include <string_view>
 
 namespace fsm::concepts
 {
@@ -76,6 +77,15 @@ concept is_std_string_constructible = std::is_default_constructible_v<T>
 	&& std::constructible_from<T, std::string>
 	&& std::regular<T>;
 
+template <typename T>
+concept combined_matcher = requires { typename T::engine_type; };
+
+template <typename T>
+concept scanning_matcher = requires(T const& matcher, std::string_view source, std::size_t pos) {
+	{ matcher.scan(source, pos).length } -> std::convertible_to<std::size_t>;
+	{ matcher.scan(source, pos).reached_end } -> std::convertible_to<bool>;
+};
+
 template <typename T>
 concept streamable = requires(std::ostream& os, const std::remove_reference_t<T>& a) {
 	{ os << a } -> std::same_as<std::ostream&>;
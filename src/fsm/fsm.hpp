@@ -5,7 +5,10 @@
 #include "converter.hpp"
 #include "dot.hpp"
 #include "lexer.hpp"
+#include "lexer_cache.hpp"
+#include "lexer_spec.hpp"
 #include "ll1.hpp"
+#include "mapped_source.hpp"
 #include "mealy/minimization.hpp"
 #include "mealy_machine.hpp"
 #include "minimization.hpp"
@@ -13,6 +16,8 @@
 #include "moore_machine.hpp"
 #include "recognizer.hpp"
 #include "regex.hpp"
+#include "regex_set.hpp"
 #include "slr.hpp"
+#include "stream_lexer.hpp"
 
 #endif // FSM_HPP
@@ -0,0 +1,9 @@
+#ifndef FSM_GLR_HPP
+#define FSM_GLR_HPP
+
+#include "glr/parser.hpp"
+#include "lr/compact_table.hpp"
+#include "lr/table.hpp"
+#include "lr/table_io.hpp"
+
+#endif // FSM_GLR_HPP
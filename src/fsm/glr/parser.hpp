@@ -0,0 +1,527 @@
+#ifndef FSM_GLR_PARSER_HPP
+#define FSM_GLR_PARSER_HPP
+
+#include "../lr/parser.hpp"
+#include "../lr/table.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <set>
+#include <span>
+#include <vector>
+
+namespace fsm::glr
+{
+struct forest_node;
+
+/// One derivation of a `forest_node`: a rule and the nodes of its right-hand side.
+struct packed_node
+{
+	std::uint32_t rule_index{};
+	std::vector<const forest_node*> children;
+
+	bool operator==(const packed_node&) const = default;
+};
+
+/**
+ * @brief A node of the shared packed parse forest built by `glr::parser`.
+ *
+ * A leaf is the token `start`. Any other node is one non-terminal over the
+ * tokens `[start, end)`, and holds every derivation of it as a family; nodes
+ * are shared by all the derivations they occur in.
+ */
+struct forest_node
+{
+	std::size_t start{};
+	std::size_t end{};
+	std::vector<packed_node> families;
+
+	[[nodiscard]] bool is_leaf() const
+	{
+		return families.empty();
+	}
+
+	[[nodiscard]] bool is_ambiguous() const
+	{
+		return families.size() > 1;
+	}
+};
+
+/// How much of the last parse ran on a single stack.
+struct parse_stats
+{
+	/// Tokens including the end marker.
+	std::size_t levels{};
+	/// Levels parsed by plain LR steps, without forking the stack.
+	std::size_t deterministic_levels{};
+};
+
+/**
+ * @brief A generalized LR parser over tables with conflicts.
+ *
+ * Cells filled by `collision_policy::keep_all` make the parser fork; the
+ * stacks share a graph-structured stack (Tomita), and ε-reductions that
+ * reach an already processed node are redone as Farshi describes. The result
+ * is a shared packed parse forest.
+ *
+ * While there is a single stack and no conflicting cell, tokens are parsed as
+ * `lr::parser` does, on a plain vector of states: only the part of the stack
+ * that a fork needs is turned into graph nodes.
+ */
+template <
+	typename T_Symbol,
+	typename T_Compare = std::less<T_Symbol>,
+	typename T_Table = lr::table<T_Symbol, T_Compare>>
+class parser
+{
+public:
+	using table_type = T_Table;
+	using symbol_type = T_Symbol;
+	using state_type = typename table_type::state_type;
+	using action_type = typename table_type::action_type;
+	using error_type = lr::event_error<T_Symbol>;
+
+	explicit parser(const table_type& tbl)
+		: m_table{ tbl }
+	{
+	}
+
+	/// The root of the forest, valid until the next `parse`.
+	std::expected<const forest_node*, error_type> parse(std::span<const T_Symbol> input)
+	{
+		m_input = input;
+		m_forest.clear();
+		m_gss.clear();
+		m_stack.clear();
+		m_frontier.clear();
+		m_stats = { .levels = input.size() + 1 };
+
+		m_base = &m_gss.emplace_back(gss_node{ .state = 0, .level = 0, .edges = {}, .processed = false });
+		bool deterministic = true;
+
+		for (m_level = 0; m_level <= input.size(); ++m_level)
+		{
+			m_level_nodes.clear();
+			m_accepted = nullptr;
+
+			if (deterministic)
+			{
+				switch (run_deterministic())
+				{
+				case step_result::shifted:
+					++m_stats.deterministic_levels;
+					continue;
+				case step_result::accepted:
+					++m_stats.deterministic_levels;
+					return m_stack.back().label;
+				case step_result::failed:
+					return std::unexpected(error_type{ lookahead(), m_table.expected_terminals(top_state()) });
+				case step_result::forked:
+					break;
+				}
+
+				fork();
+				deterministic = false;
+			}
+
+			run_actors();
+
+			if (m_accepted != nullptr)
+			{
+				return m_accepted->edges.front().label;
+			}
+
+			if (!shift())
+			{
+				return std::unexpected(error_type{ lookahead(), expected_tokens() });
+			}
+
+			if (m_frontier.size() == 1)
+			{
+				m_base = m_frontier.front();
+				m_frontier.clear();
+				deterministic = true;
+			}
+		}
+
+		return std::unexpected(error_type{ m_table.end_marker(), expected_tokens() });
+	}
+
+	/// The token of a leaf of the last parse, or the non-terminal of any other node.
+	const T_Symbol& symbol(const forest_node& node) const
+	{
+		return node.is_leaf() ? m_input[node.start] : m_table.rule(node.families.front().rule_index).lhs;
+	}
+
+	[[nodiscard]] const parse_stats& stats() const
+	{
+		return m_stats;
+	}
+
+private:
+	struct gss_node;
+
+	struct gss_edge
+	{
+		gss_node* target;
+		forest_node* label;
+	};
+
+	struct gss_node
+	{
+		state_type state{};
+		std::size_t level{};
+		std::vector<gss_edge> edges;
+		bool processed = false;
+	};
+
+	/// A state above `m_base` while parsing deterministically.
+	struct stack_entry
+	{
+		state_type state;
+		std::size_t level;
+		forest_node* label;
+	};
+
+	struct level_node
+	{
+		std::uint32_t lhs_column;
+		std::size_t start;
+		forest_node* node;
+	};
+
+	enum class step_result : std::uint8_t
+	{
+		shifted,
+		accepted,
+		failed,
+		forked,
+	};
+
+	const table_type& m_table;
+	std::span<const T_Symbol> m_input;
+	std::size_t m_level = 0;
+
+	std::deque<forest_node> m_forest;
+	std::deque<gss_node> m_gss;
+
+	gss_node* m_base = nullptr;
+	std::vector<stack_entry> m_stack;
+
+	std::vector<gss_node*> m_frontier;
+	std::vector<std::pair<gss_node*, state_type>> m_shifts;
+	std::vector<level_node> m_level_nodes;
+	gss_node* m_accepted = nullptr;
+
+	parse_stats m_stats;
+
+	const T_Symbol& lookahead() const
+	{
+		return m_level < m_input.size() ? m_input[m_level] : m_table.end_marker();
+	}
+
+	state_type top_state() const
+	{
+		return m_stack.empty() ? m_base->state : m_stack.back().state;
+	}
+
+	std::size_t top_level() const
+	{
+		return m_stack.empty() ? m_base->level : m_stack.back().level;
+	}
+
+	/// LR steps on the current token until it is shifted or the stack has to fork.
+	step_result run_deterministic()
+	{
+		const T_Symbol& token = lookahead();
+		while (true)
+		{
+			const state_type state = top_state();
+			if (!m_table.conflicting_actions(state, token).empty())
+			{
+				return step_result::forked;
+			}
+
+			const auto& act = m_table.get_action(state, token);
+			if (lr::actions::is_shift(act))
+			{
+				m_stack.push_back({ lr::actions::as_shift(act).target_state, m_level + 1, make_leaf() });
+
+				return step_result::shifted;
+			}
+			if (lr::actions::is_accept(act))
+			{
+				return m_stack.empty() ? step_result::forked : step_result::accepted;
+			}
+			if (lr::actions::is_error(act))
+			{
+				return step_result::failed;
+			}
+
+			const auto reduce = lr::actions::as_reduce(act);
+			if (reduce.pop_count > m_stack.size())
+			{
+				return step_result::forked;
+			}
+
+			const auto first = m_stack.end() - reduce.pop_count;
+			std::vector<const forest_node*> children;
+			children.reserve(reduce.pop_count);
+			for (auto it = first; it != m_stack.end(); ++it)
+			{
+				children.push_back(it->label);
+			}
+			m_stack.erase(first, m_stack.end());
+
+			const auto target = m_table.get_goto(top_state(), reduce);
+			if (!target)
+			{
+				return step_result::failed;
+			}
+
+			forest_node* node = symbol_node(reduce, top_level());
+			add_family(node, reduce, std::move(children));
+			m_stack.push_back({ *target, m_level, node });
+		}
+	}
+
+	/// Moves the deterministic stack into the graph; its top becomes the only frontier node.
+	void fork()
+	{
+		gss_node* top = m_base;
+		for (const auto& entry : m_stack)
+		{
+			gss_node* node = &m_gss.emplace_back(gss_node{ .state = entry.state, .level = entry.level, .edges = {}, .processed = false });
+			node->edges.push_back({ top, entry.label });
+			top = node;
+		}
+
+		m_stack.clear();
+		m_frontier = { top };
+	}
+
+	std::vector<action_type> actions_of(const state_type state) const
+	{
+		const auto& token = lookahead();
+		std::vector<action_type> result;
+		if (const auto& act = m_table.get_action(state, token); !lr::actions::is_error(act))
+		{
+			result.push_back(act);
+		}
+		for (const auto& act : m_table.conflicting_actions(state, token))
+		{
+			result.push_back(act);
+		}
+
+		return result;
+	}
+
+	void run_actors()
+	{
+		m_shifts.clear();
+
+		// Reductions append to the frontier while it is walked.
+		for (std::size_t i = 0; i < m_frontier.size(); ++i)
+		{
+			gss_node* node = m_frontier[i];
+			node->processed = true;
+
+			for (const auto& act : actions_of(node->state))
+			{
+				if (lr::actions::is_shift(act))
+				{
+					m_shifts.emplace_back(node, lr::actions::as_shift(act).target_state);
+				}
+				else if (lr::actions::is_accept(act))
+				{
+					m_accepted = node;
+				}
+				else if (lr::actions::is_reduce(act))
+				{
+					reduce_paths(node, lr::actions::as_reduce(act), nullptr, 0);
+				}
+			}
+		}
+	}
+
+	/// Reduces along every path from `node`; with `via`, only along paths that use its edge `via_edge`.
+	void reduce_paths(gss_node* node, const lr::action_reduce& reduce, const gss_node* via, const std::size_t via_edge)
+	{
+		std::vector<forest_node*> labels;
+		walk(node, reduce, reduce.pop_count, via, via_edge, via == nullptr, labels);
+	}
+
+	void walk(
+		gss_node* node,
+		const lr::action_reduce& reduce,
+		const std::uint32_t remaining,
+		const gss_node* via,
+		const std::size_t via_edge,
+		const bool used_via,
+		std::vector<forest_node*>& labels)
+	{
+		if (remaining == 0)
+		{
+			if (used_via)
+			{
+				reduce_to(node, reduce, { labels.rbegin(), labels.rend() });
+			}
+			return;
+		}
+
+		// Edges added meanwhile are handled when they are added.
+		const std::size_t edge_count = node->edges.size();
+		for (std::size_t e = 0; e < edge_count; ++e)
+		{
+			const auto [target, label] = node->edges[e];
+			labels.push_back(label);
+			walk(target, reduce, remaining - 1, via, via_edge, used_via || (node == via && e == via_edge), labels);
+			labels.pop_back();
+		}
+	}
+
+	void reduce_to(gss_node* bottom, const lr::action_reduce& reduce, std::vector<const forest_node*> children)
+	{
+		const auto target = m_table.get_goto(bottom->state, reduce);
+		if (!target)
+		{
+			return;
+		}
+
+		gss_node* node = nullptr;
+		for (gss_node* candidate : m_frontier)
+		{
+			if (candidate->state == *target)
+			{
+				node = candidate;
+				break;
+			}
+		}
+
+		if (node == nullptr)
+		{
+			forest_node* label = symbol_node(reduce, bottom->level);
+			add_family(label, reduce, std::move(children));
+
+			node = &m_gss.emplace_back(gss_node{ .state = *target, .level = m_level, .edges = {}, .processed = false });
+			node->edges.push_back({ bottom, label });
+			m_frontier.push_back(node);
+			return;
+		}
+
+		for (const auto& edge : node->edges)
+		{
+			if (edge.target == bottom)
+			{
+				add_family(edge.label, reduce, std::move(children));
+				return;
+			}
+		}
+
+		forest_node* label = symbol_node(reduce, bottom->level);
+		add_family(label, reduce, std::move(children));
+		node->edges.push_back({ bottom, label });
+
+		if (!node->processed)
+		{
+			return;
+		}
+
+		// Farshi: processed nodes may reach the new edge through ε-edges of this level.
+		const std::size_t new_edge = node->edges.size() - 1;
+		for (std::size_t i = 0; i < m_frontier.size(); ++i)
+		{
+			if (!m_frontier[i]->processed)
+			{
+				continue;
+			}
+
+			for (const auto& act : actions_of(m_frontier[i]->state))
+			{
+				if (lr::actions::is_reduce(act) && lr::actions::as_reduce(act).pop_count > 0)
+				{
+					reduce_paths(m_frontier[i], lr::actions::as_reduce(act), node, new_edge);
+				}
+			}
+		}
+	}
+
+	bool shift()
+	{
+		if (m_shifts.empty())
+		{
+			return false;
+		}
+
+		forest_node* leaf = make_leaf();
+		std::vector<gss_node*> next;
+		for (const auto& [from, target] : m_shifts)
+		{
+			auto it = std::ranges::find(next, target, &gss_node::state);
+			gss_node* node = it != next.end()
+				? *it
+				: next.emplace_back(&m_gss.emplace_back(gss_node{ .state = target, .level = m_level + 1, .edges = {}, .processed = false }));
+			node->edges.push_back({ from, leaf });
+		}
+
+		m_frontier = std::move(next);
+
+		return true;
+	}
+
+	std::vector<T_Symbol> expected_tokens() const
+	{
+		std::set<T_Symbol, T_Compare> expected;
+		for (const gss_node* node : m_frontier)
+		{
+			for (auto& terminal : m_table.expected_terminals(node->state))
+			{
+				expected.insert(std::move(terminal));
+			}
+		}
+
+		return { expected.begin(), expected.end() };
+	}
+
+	forest_node* make_leaf()
+	{
+		return &m_forest.emplace_back(forest_node{ .start = m_level, .end = m_level + 1, .families = {} });
+	}
+
+	/// The node of the reduced non-terminal over `[start, m_level)`, shared within the level.
+	forest_node* symbol_node(const lr::action_reduce& reduce, const std::size_t start)
+	{
+		for (const auto& [lhs_column, node_start, node] : m_level_nodes)
+		{
+			if (lhs_column == reduce.lhs_column && node_start == start)
+			{
+				return node;
+			}
+		}
+
+		forest_node* node = &m_forest.emplace_back(forest_node{ .start = start, .end = m_level, .families = {} });
+		m_level_nodes.push_back({ reduce.lhs_column, start, node });
+
+		return node;
+	}
+
+	static void add_family(forest_node* node, const lr::action_reduce& reduce, std::vector<const forest_node*> children)
+	{
+		packed_node family{ reduce.rule_index, std::move(children) };
+		if (std::ranges::find(node->families, family) == node->families.end())
+		{
+			node->families.push_back(std::move(family));
+		}
+	}
+};
+
+template <typename T_Symbol, typename T_Compare>
+parser(const lr::table<T_Symbol, T_Compare>&) -> parser<T_Symbol, T_Compare, lr::table<T_Symbol, T_Compare>>;
+
+template <typename T_Symbol, typename T_Compare>
+parser(const lr::compact_table<T_Symbol, T_Compare>&) -> parser<T_Symbol, T_Compare, lr::compact_table<T_Symbol, T_Compare>>;
+} // namespace fsm::glr
+
+#endif // FSM_GLR_PARSER_HPP
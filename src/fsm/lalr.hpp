@@ -2,7 +2,12 @@
 #define FSM_LALR_HPP
 
 #include "lalr/table_builder.hpp"
+#include "lr/ast_builder.hpp"
+#include "lr/compact_table.hpp"
+#include "lr/incremental_parser.hpp"
 #include "lr/parser.hpp"
+#include "lr/semantic_parser.hpp"
 #include "lr/table.hpp"
+#include "lr/table_io.hpp"
 
 #endif // FSM_LALR_HPP
@@ -3,36 +3,21 @@
 
 #include "../cfg/cfg_algorithms.hpp"
 #include "../lr/basic_table_builder.hpp"
-#include "../lr/lr0_item.hpp"
+#include "../lr/lr0_automaton.hpp"
 #include "../lr/table.hpp"
 
 #include <expected>
-#include <queue>
-#include <set>
+#include <utility>
+#include <vector>
 
 namespace fsm::lalr
 {
-namespace detail
-{
-struct propagation_edge
-{
-	std::size_t from_state;
-	std::size_t from_item_index;
-
-	std::size_t to_state;
-	std::size_t to_item_index;
-};
-} // namespace detail
-
 template <typename T_Symbol, typename T_Compare = std::less<T_Symbol>>
 class table_builder : public lr::basic_table_builder<table_builder<T_Symbol, T_Compare>, T_Symbol, T_Compare>
 {
 	using base_t = lr::basic_table_builder<table_builder, T_Symbol, T_Compare>;
 
-	using lr0_item_t = lr::lr0_item<T_Symbol>;
-
-	using lr1_state_t = std::map<lr0_item_t, std::set<T_Symbol, T_Compare>>;
-	using first_sets_t = std::map<T_Symbol, std::set<T_Symbol, T_Compare>, T_Compare>;
+	using typename base_t::lr1_state_t;
 
 public:
 	explicit table_builder(const basic_cfg<T_Symbol, T_Compare>& grammar)
@@ -49,141 +34,46 @@ public:
 	{
 	}
 
+	/// Threads that expand LR(0) states while building; the table does not depend on it.
+	table_builder& with_thread_count(std::size_t thread_count)
+	{
+		m_thread_count = thread_count;
+
+		return *this;
+	}
+
+	/**
+	 * Builds the LR(0) automaton and computes the LALR(1) lookaheads of its
+	 * kernel items by spontaneous generation and propagation (Dragon Book,
+	 * 4.7.5). States are numbered in breadth-first order, so the table is the
+	 * one that merging the canonical LR(1) collection by core would give.
+	 */
 	template <typename T_CollisionPolicy = lr::detail::strict_t>
 	std::expected<typename base_t::table_type, std::vector<lr::conflict_error<T_Symbol>>>
 	build(T_CollisionPolicy policy = lr::collision_policy::strict) const
 	{
-		using core_set_t = std::set<lr0_item_t>;
-
 		typename base_t::table_type result;
 
 		result.set_end_marker(this->m_eof);
 		std::vector<lr::conflict_error<T_Symbol>> errors;
 
-		auto first_sets = algorithms::compute_first(this->m_grammar, this->m_epsilon);
-
-		using rules_map_t = std::map<T_Symbol, std::vector<cfg_rule<T_Symbol>>, T_Compare>;
-		rules_map_t rules_by_lhs;
-		for (const auto& r : this->m_grammar.rules())
-		{
-			rules_by_lhs[r.lhs].push_back(r);
-		}
-
-		lr0_item_t start_item{ { this->m_aug_start, { this->m_grammar.start_symbol() } }, 0 };
-		lr1_state_t initial_state;
-		initial_state[start_item].insert(this->m_eof);
-		initial_state = compute_closure(initial_state, first_sets, rules_by_lhs);
-
-		std::vector<lr1_state_t> lr1_states;
-		std::map<lr1_state_t, std::size_t> state_to_id;
-		std::map<std::pair<std::size_t, T_Symbol>, std::size_t> lr1_transitions;
-
-		lr1_states.push_back(initial_state);
-		state_to_id[initial_state] = 0;
-
-		std::queue<std::size_t> q;
-		q.push(0);
-
-		while (!q.empty())
-		{
-			std::size_t current_id = q.front();
-			q.pop();
-			const lr1_state_t current_state = lr1_states[current_id];
-
-			std::set<T_Symbol, T_Compare> next_symbols;
-			for (const auto& [item, _] : current_state)
-			{
-				if (!item.is_complete() && item.next_symbol() != this->m_epsilon)
-				{
-					next_symbols.insert(item.next_symbol());
-				}
-			}
-
-			for (const auto& X : next_symbols)
-			{
-				lr1_state_t next_state = compute_goto(current_state, X, first_sets, rules_by_lhs);
-				if (next_state.empty())
-				{
-					continue;
-				}
-
-				if (!state_to_id.contains(next_state))
-				{
-					std::size_t new_id = lr1_states.size();
-					lr1_states.push_back(next_state);
-					state_to_id[next_state] = new_id;
-					q.push(new_id);
-				}
+		const auto first_sets = algorithms::compute_first(this->m_grammar, this->m_epsilon);
+		const auto items = this->make_item_grammar();
 
-				lr1_transitions[{ current_id, X }] = state_to_id[next_state];
-			}
-		}
+		const auto [kernels, lalr_transitions] = lr::detail::build_lr0_automaton(items, m_thread_count);
+		const auto kernel_lookaheads = this->compute_lookaheads(kernels, lalr_transitions, first_sets, items);
 
-		std::vector<lr1_state_t> lalr_states;
-		std::map<core_set_t, std::size_t> core_to_lalr_index;
-		std::map<std::size_t, std::size_t> lr1_to_lalr;
-
-		for (std::size_t i = 0; i < lr1_states.size(); ++i)
+		std::vector<lr1_state_t> lalr_states(kernels.size());
+		for (std::size_t i = 0; i < kernels.size(); ++i)
 		{
-			core_set_t core;
-			for (const auto& [item, _] : lr1_states[i])
-			{
-				core.insert(item);
-			}
-
-			if (!core_to_lalr_index.contains(core))
+			for (std::size_t k = 0; k < kernels[i].size(); ++k)
 			{
-				core_to_lalr_index[core] = lalr_states.size();
-				lalr_states.push_back(lr1_states[i]);
-				lr1_to_lalr[i] = core_to_lalr_index[core];
-			}
-			else
-			{
-				std::size_t lalr_idx = core_to_lalr_index[core];
-				lr1_to_lalr[i] = lalr_idx;
-
-				for (const auto& [item, lookaheads] : lr1_states[i])
-				{
-					lalr_states[lalr_idx][item].insert(lookaheads.begin(), lookaheads.end());
-				}
+				lalr_states[i][kernels[i][k]] = kernel_lookaheads[i][k];
 			}
+			lalr_states[i] = this->compute_closure(std::move(lalr_states[i]), first_sets, items);
 		}
 
-		std::map<std::pair<std::size_t, T_Symbol>, std::size_t> lalr_transitions;
-		for (const auto& [key, target_lr1] : lr1_transitions)
-		{
-			const auto& [source_lr1, sym] = key;
-			lalr_transitions[{ lr1_to_lalr[source_lr1], sym }] = lr1_to_lalr[target_lr1];
-		}
-
-		for (std::size_t i = 0; i < lalr_states.size(); ++i)
-		{
-			for (const auto& [item, lookaheads] : lalr_states[i])
-			{
-				if (!item.is_complete())
-				{ // SHIFT or GOTO
-					if (T_Symbol a = item.next_symbol(); this->m_grammar.is_terminal(a) && lalr_transitions.contains({ i, a }))
-					{
-						this->try_add_action(result, i, a, lr::action_shift<std::size_t>{ lalr_transitions.at({ i, a }) }, policy, errors);
-					}
-					else if (this->m_grammar.is_non_terminal(a) && lalr_transitions.contains({ i, a }))
-					{
-						result.add_goto(i, a, lalr_transitions.at({ i, a }));
-					}
-				}
-				else if (item.rule.lhs == this->m_aug_start)
-				{ // ACCEPT
-					this->try_add_action(result, i, this->m_eof, lr::action_accept{}, policy, errors);
-				}
-				else
-				{ // REDUCE
-					for (const auto& a : lookaheads)
-					{
-						this->try_add_action(result, i, a, lr::action_reduce<T_Symbol>{ item.rule }, policy, errors);
-					}
-				}
-			}
-		}
+		this->add_lr1_actions(result, lalr_states, lalr_transitions, items, policy, errors);
 
 		if constexpr (std::is_same_v<T_CollisionPolicy, lr::detail::strict_t>)
 		{
@@ -196,130 +86,22 @@ public:
 		return result;
 	}
 
-private:
-	using rules_map_t = std::map<T_Symbol, std::vector<cfg_rule<T_Symbol>>, T_Compare>;
-
-	struct closure_result
-	{
-		std::set<lr0_item_t> items;
-		std::map<lr0_item_t, std::set<T_Symbol, T_Compare>> lookaheads;
-	};
-
-	lr1_state_t compute_closure(lr1_state_t I, first_sets_t const& first_sets, rules_map_t const& rules_by_lhs) const
-	{
-		bool changed = true;
-		while (changed)
-		{
-			changed = false;
-			lr1_state_t additions;
-
-			for (const auto& [item, lookaheads] : I)
-			{
-				if (item.is_complete() || this->m_grammar.is_terminal(item.next_symbol()))
-				{
-					continue;
-				}
-
-				T_Symbol B = item.next_symbol();
-
-				auto rules_it = rules_by_lhs.find(B);
-				if (rules_it == rules_by_lhs.end())
-				{
-					continue;
-				}
-
-				std::set<T_Symbol, T_Compare> first_beta;
-				bool beta_has_epsilon = true;
-
-				for (std::size_t i = item.dot + 1; i < item.rule.rhs.size(); ++i)
-				{
-					const auto& sym = item.rule.rhs[i];
-					if (!first_sets.contains(sym))
-					{
-						first_beta.insert(sym);
-						beta_has_epsilon = false;
-						break;
-					}
-
-					const auto& sym_first = first_sets.at(sym);
-					for (const auto& a : sym_first)
-					{
-						if (a != this->m_epsilon)
-						{
-							first_beta.insert(a);
-						}
-					}
-
-					if (!sym_first.contains(this->m_epsilon))
-					{
-						beta_has_epsilon = false;
-						break;
-					}
-				}
-
-				for (const auto& rule : rules_it->second)
-				{
-					std::size_t initial_dot = (rule.rhs.size() == 1 && rule.rhs[0] == this->m_epsilon) ? 1 : 0;
-					lr0_item_t new_core{ rule, initial_dot };
-
-					auto& target_la = additions[new_core];
-
-					target_la.insert(first_beta.begin(), first_beta.end());
-
-					if (beta_has_epsilon)
-					{
-						target_la.insert(lookaheads.begin(), lookaheads.end());
-					}
-				}
-			}
-
-			for (auto& [new_item, new_lookaheads] : additions)
-			{
-				auto& existing_la = I[new_item];
-				std::size_t old_size = existing_la.size();
-
-				existing_la.insert(new_lookaheads.begin(), new_lookaheads.end());
-
-				if (existing_la.size() > old_size)
-				{
-					changed = true;
-				}
-			}
-		}
-
-		return I;
-	}
-
-	lr1_state_t compute_goto(lr1_state_t const& I, T_Symbol const& X, first_sets_t const& first_sets, rules_map_t const& rules_by_lhs) const
+	/// Same as `build`, frozen into an `lr::compact_table` for parsing.
+	template <typename T_CollisionPolicy = lr::detail::strict_t>
+	std::expected<typename base_t::compact_table_type, std::vector<lr::conflict_error<T_Symbol>>>
+	build_compact(T_CollisionPolicy policy = lr::collision_policy::strict) const
 	{
-		lr1_state_t J;
-		for (const auto& [item, lookaheads] : I)
+		auto result = build(policy);
+		if (!result)
 		{
-			if (!item.is_complete() && item.next_symbol() == X)
-			{
-				lr0_item_t next_core = item;
-				++next_core.dot;
-				J[next_core] = lookaheads;
-			}
+			return std::unexpected(std::move(result.error()));
 		}
 
-		return compute_closure(J, first_sets, rules_by_lhs);
+		return typename base_t::compact_table_type(*result);
 	}
 
-	std::set<T_Symbol, T_Compare> compute_first_of_sequence_with_la(
-		const std::vector<T_Symbol>& beta,
-		const T_Symbol& la,
-		const first_sets_t& first_sets) const
-	{
-		auto res = algorithms::impl::ComputeFirstOf_fn{}(beta, first_sets, this->m_epsilon);
-
-		if (res.contains(this->m_epsilon))
-		{
-			res.erase(this->m_epsilon);
-			res.insert(la);
-		}
-		return res;
-	}
+private:
+	std::size_t m_thread_count = 1;
 };
 
 template <typename T_Symbol, typename T_Compare>
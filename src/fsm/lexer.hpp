@@ -1,51 +1,143 @@
 #ifndef FSM_LEXER_HPP
 #define FSM_LEXER_HPP
 
+#include "byte_dfa.hpp"
+#include "concepts.hpp"
+#include "line_index.hpp"
 #include "minimization.hpp"
+#include "prefilter.hpp"
 #include "recognizer.hpp"
 #include "regex.hpp"
+#include "token_buffer.hpp"
 
+#include <algorithm>
 #include <expected>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <span>
 #include <string_view>
+#include <thread>
+#include <variant>
 
 namespace fsm
 {
-struct fsm_regex_matcher final
+struct match_span
 {
-	recognizer recognizer;
+	std::size_t offset{};
+	std::size_t length{};
+};
+
+struct match_scan
+{
+	std::size_t length{};
+	// The automaton was still alive when it ran out of input, so more input could extend the match.
+	bool reached_end{};
+};
+
+/**
+ * @brief Matches one pattern with its own byte automaton.
+ *
+ * `T_Regex` picks the pattern syntax; `T_Columns` is the column unit a lexer
+ * using this matcher reports by default, code points for `utf8_regex` and
+ * bytes otherwise.
+ */
+template <typename T_Regex, column_unit T_Columns = std::same_as<T_Regex, utf8_regex> ? column_unit::code_points : column_unit::bytes>
+struct basic_fsm_regex_matcher final
+{
+	static constexpr column_unit columns = T_Columns;
 
-	static fsm_regex_matcher compile(const std::string& pattern)
+	byte_dfa dfa;
+	literal_prefilter prefilter;
+
+	static basic_fsm_regex_matcher compile(const std::string& pattern)
 	{
-		regex re(pattern);
+		T_Regex re(pattern);
+		literal_prefilter prefilter(details::literal_extractor{}(re.syntax_tree()));
+
 		const auto nfa = re.compile();
-		return fsm_regex_matcher{ minimize(determinize(nfa)) };
+		details::byte_dfa_compiler::final_tags_type final_tags;
+		for (auto const& final_id : nfa.state().final_state_ids)
+		{
+			final_tags.emplace(final_id, 0);
+		}
+
+		auto dfa = details::byte_dfa_compiler{}(nfa.state(), final_tags, [](auto const&) { return 1; });
+
+		return basic_fsm_regex_matcher{ std::move(dfa), std::move(prefilter) };
 	}
 
 	[[nodiscard]] std::size_t
 	find_match(const std::string_view source, const std::size_t start_pos) const
 	{
-		fsm::recognizer machine_run = recognizer;
+		if (!prefilter.may_start_at(source, start_pos))
+		{
+			return 0;
+		}
+
+		return scan(source, start_pos).length;
+	}
+
+	[[nodiscard]] match_scan
+	scan(const std::string_view source, const std::size_t start_pos) const
+	{
+		const auto* const classes = dfa.byte_classes.data();
+		const auto* const transitions = dfa.transitions.data();
+		const auto* const accepting = dfa.accept_tags.data();
+		const std::size_t class_count = dfa.class_count;
+
+		auto state = dfa.start_state;
 		std::size_t last_final_len = 0;
 
 		for (std::size_t i = start_pos; i < source.length(); ++i)
 		{
-			try
+			state = transitions[state * class_count + classes[static_cast<unsigned char>(source[i])]];
+			if (state == byte_dfa::dead_state)
 			{
-				if (machine_run.handle_input(std::make_optional(std::string(1, source[i]))))
-				{
-					last_final_len = i - start_pos + 1;
-				}
+				return { last_final_len, false };
 			}
-			catch (...)
+
+			if (accepting[state] != byte_dfa::no_tag)
+			{
+				last_final_len = i - start_pos + 1;
+			}
+		}
+
+		return { last_final_len, true };
+	}
+
+	[[nodiscard]] std::optional<match_span>
+	search(const std::string_view source, const std::size_t start_pos = 0) const
+	{
+		if (!prefilter.may_occur_in(source, start_pos))
+		{
+			return std::nullopt;
+		}
+
+		for (std::size_t pos = start_pos; pos < source.length(); ++pos)
+		{
+			pos = prefilter.next_candidate(source, pos);
+			if (pos == literal_prefilter::npos)
 			{
 				break;
 			}
+
+			if (const std::size_t length = scan(source, pos).length; length > 0)
+			{
+				return match_span{ pos, length };
+			}
 		}
 
-		return last_final_len;
+		return std::nullopt;
 	}
 };
 
+using fsm_regex_matcher = basic_fsm_regex_matcher<regex>;
+
+/// Patterns are UTF-8 with code point classes such as `[α-ω]`; columns count code points.
+using utf8_regex_matcher = basic_fsm_regex_matcher<utf8_regex>;
+
 struct std_regex_matcher final
 {
 	std::regex regex;
@@ -58,6 +150,11 @@ struct std_regex_matcher final
 	[[nodiscard]] std::size_t
 	find_match(const std::string_view source, const std::size_t start_pos) const
 	{
+		if (start_pos > source.size())
+		{
+			return 0;
+		}
+
 		constexpr auto flags = std::regex_constants::match_continuous;
 		if (std::cmatch match; std::regex_search(
 				source.data() + start_pos,
@@ -69,6 +166,152 @@ struct std_regex_matcher final
 
 		return 0;
 	}
+
+	[[nodiscard]] std::optional<match_span>
+	search(const std::string_view source, const std::size_t start_pos = 0) const
+	{
+		if (start_pos > source.size())
+		{
+			return std::nullopt;
+		}
+
+		if (std::cmatch match; std::regex_search(
+				source.data() + start_pos,
+				source.data() + source.size(),
+				match, regex))
+		{
+			return match_span{ start_pos + match.position(), static_cast<std::size_t>(match.length()) };
+		}
+
+		return std::nullopt;
+	}
+};
+
+struct combined_dfa_matcher final
+{
+	class engine
+	{
+	public:
+		struct match
+		{
+			std::size_t rule_index{};
+			std::size_t length{};
+		};
+
+		engine() = default;
+
+		template <std::ranges::input_range T_Matchers>
+		explicit engine(T_Matchers&& matchers)
+		{
+			const std::string start = "lexer_start";
+
+			recognizer_state nfa;
+			nfa.initial_state_id = start;
+			nfa.state_ids.insert(start);
+
+			details::regex_builder builder;
+			details::byte_dfa_compiler::final_tags_type final_tags;
+
+			std::uint32_t rule_index = 0;
+			for (combined_dfa_matcher const& matcher : matchers)
+			{
+				const auto fragment = builder(details::regex_parser{}(matcher.pattern));
+
+				nfa.state_ids.insert(fragment.state_ids.begin(), fragment.state_ids.end());
+				nfa.transitions.insert(fragment.transitions.begin(), fragment.transitions.end());
+				nfa.transitions.emplace(std::make_pair(start, std::nullopt), fragment.initial_state_id);
+
+				for (auto const& final_id : fragment.final_state_ids)
+				{
+					nfa.final_state_ids.insert(final_id);
+					final_tags.emplace(final_id, rule_index);
+				}
+				++rule_index;
+			}
+
+			// Tags are sorted, so the earliest added rule wins on equal length.
+			m_owned = std::make_shared<const byte_dfa>(details::byte_dfa_compiler{}(nfa, final_tags, [](std::vector<std::uint32_t> const& rules) {
+				return rules.front() + 1;
+			}));
+			m_dfa = m_owned->view();
+		}
+
+		/// Scans with tables owned by someone else, who must keep them alive.
+		explicit engine(const byte_dfa_view dfa)
+			: m_dfa{ dfa }
+		{
+		}
+
+		struct scan_result
+		{
+			std::optional<match> longest;
+			bool reached_end{};
+		};
+
+		[[nodiscard]] std::optional<match>
+		longest_match(const std::string_view source, const std::size_t start_pos) const
+		{
+			return scan(source, start_pos).longest;
+		}
+
+		[[nodiscard]] scan_result
+		scan(const std::string_view source, const std::size_t start_pos) const
+		{
+			auto state = m_dfa.start_state;
+			byte_dfa::tag_type last_tag = byte_dfa::no_tag;
+			std::size_t last_length = 0;
+			bool reached_end = true;
+
+			for (std::size_t i = start_pos; i < source.length(); ++i)
+			{
+				state = m_dfa.next(state, static_cast<unsigned char>(source[i]));
+				if (state == byte_dfa::dead_state)
+				{
+					reached_end = false;
+					break;
+				}
+
+				if (const auto tag = m_dfa.accept_tag(state); tag != byte_dfa::no_tag)
+				{
+					last_tag = tag;
+					last_length = i - start_pos + 1;
+				}
+			}
+
+			if (last_tag == byte_dfa::no_tag)
+			{
+				return { std::nullopt, reached_end };
+			}
+
+			return { match{ last_tag - 1, last_length }, reached_end };
+		}
+
+		[[nodiscard]] byte_dfa_view dfa() const
+		{
+			return m_dfa;
+		}
+
+	private:
+		std::shared_ptr<const byte_dfa> m_owned;
+		byte_dfa_view m_dfa = empty_dfa().view();
+
+		static byte_dfa const& empty_dfa()
+		{
+			static const byte_dfa dfa;
+			return dfa;
+		}
+	};
+
+	using engine_type = engine;
+
+	std::string pattern;
+
+	static combined_dfa_matcher compile(const std::string& pattern)
+	{
+		std::ignore = details::regex_parser{}(pattern);
+
+		return combined_dfa_matcher{ pattern };
+	}
 };
 
 template <typename T_Type>
@@ -81,6 +324,31 @@ struct token
 	std::size_t column{};
 	std::size_t offset{};
 	std::size_t length{};
+
+	[[nodiscard]] source_position position(line_index const& lines, const column_unit unit = column_unit::bytes) const
+	{
+		return lines.at(offset, unit);
+	}
+};
+
+/// A replacement of `removed` bytes at `offset` by `inserted`.
+struct source_edit
+{
+	std::size_t offset{};
+	std::size_t removed{};
+	std::string_view inserted;
+};
+
+/**
+ * `eager` keeps `token::line`/`token::column` up to date while lexing.
+ * `lazy` leaves them at 0 and only advances the offset; positions are then
+ * looked up through `token::position(lexer::lines(), lexer::columns())` when
+ * needed.
+ */
+enum class position_tracking
+{
+	eager,
+	lazy
 };
 
 struct lexer_error
@@ -97,11 +365,40 @@ struct lexer_error
 	}
 };
 
+namespace details
+{
+template <typename T_Matcher>
+struct matcher_engine
+{
+	using type = std::monostate;
+};
+
+template <concepts::combined_matcher T_Matcher>
+struct matcher_engine<T_Matcher>
+{
+	using type = typename T_Matcher::engine_type;
+};
+
+template <typename T_Matcher>
+constexpr column_unit matcher_columns()
+{
+	if constexpr (requires { T_Matcher::columns; })
+	{
+		return T_Matcher::columns;
+	}
+	else
+	{
+		return column_unit::bytes;
+	}
+}
+} // namespace details
+
 template <typename T_TokenType, typename T_Matcher = fsm_regex_matcher>
 class lexer
 {
 	using token_t = token<T_TokenType>;
 	using optional_token = std::optional<token_t>;
+	using engine_t = typename details::matcher_engine<T_Matcher>::type;
 	using error_type = std::optional<T_TokenType>;
 
 	template <typename T>
@@ -138,6 +435,7 @@ public:
 		m_rules.emplace_back(type, T_Matcher::compile(expression), skip);
 
 		m_peek_buffer.reset();
+		m_engine.reset();
 
 		return *this;
 	}
@@ -151,14 +449,81 @@ public:
 		m_column = 1;
 
 		m_peek_buffer.reset();
+		m_lines.reset();
 
 		return *this;
 	}
 
+	[[nodiscard]] std::vector<rule> const& rules() const
+	{
+		return m_rules;
+	}
+
+	/// The automaton of all rules, built on first use.
+	[[nodiscard]] engine_t const& engine()
+		requires concepts::combined_matcher<T_Matcher>
+	{
+		return *ensure_engine();
+	}
+
+	/// Uses an already built automaton for the current rules, e.g. one loaded from a cache.
+	lexer& with_engine(engine_t engine)
+		requires concepts::combined_matcher<T_Matcher>
+	{
+		m_engine.emplace(std::move(engine));
+		m_peek_buffer.reset();
+
+		return *this;
+	}
+
+	lexer& with_position_tracking(const position_tracking tracking)
+	{
+		if (m_tracking == position_tracking::lazy && tracking == position_tracking::eager)
+		{
+			const auto position = lines().at(m_cursor, m_columns);
+			m_line = position.line;
+			m_column = position.column;
+		}
+		m_tracking = tracking;
+
+		return *this;
+	}
+
+	/// Defaults to the matcher's unit: bytes, or code points for `utf8_regex_matcher`.
+	lexer& with_column_unit(const column_unit unit)
+	{
+		if (m_tracking == position_tracking::eager && unit != m_columns)
+		{
+			m_column = lines().at(m_cursor, unit).column;
+		}
+		m_columns = unit;
+
+		return *this;
+	}
+
+	[[nodiscard]] column_unit columns() const
+	{
+		return m_columns;
+	}
+
+	/// Newline index of the current source, built on first use.
+	line_index const& lines()
+	{
+		if (!m_lines)
+		{
+			m_lines.emplace(m_source);
+		}
+
+		return *m_lines;
+	}
+
 	lexer& clear_rules()
 	{
 		m_rules.clear();
 
+		m_peek_buffer.reset();
+		m_engine.reset();
+
 		return *this;
 	}
 
@@ -199,6 +564,242 @@ public:
 		return tokens;
 	}
 
+	/// Appends tokens to `out` until it is full or the source ends; returns how many were appended.
+	expected_value<std::size_t> tokenize_into(token_buffer<T_TokenType>& out)
+	{
+		return fill_buffer(out, [](token_buffer<T_TokenType> const&) { return false; });
+	}
+
+	/**
+	 * @brief Tokenizes the rest of the source into `out`, handing it to `on_full` each time it fills up.
+	 *
+	 * The buffer is cleared after every call of `on_full`, so the last, partial
+	 * batch is left in it. Returns the total number of tokens produced.
+	 */
+	template <std::invocable<token_buffer<T_TokenType>&> T_OnFull>
+	expected_value<std::size_t> tokenize_into(token_buffer<T_TokenType>& out, T_OnFull&& on_full)
+	{
+		return fill_buffer(out, [&](token_buffer<T_TokenType>& buffer) {
+			std::invoke(on_full, buffer);
+			buffer.clear();
+
+			return true;
+		});
+	}
+
+	/**
+	 * @brief Tokenizes the rest of the source on several threads.
+	 *
+	 * The source is cut into chunks, each lexed speculatively from the start
+	 * state at its first byte. Chunks are then stitched in order: the exact run
+	 * coming from the previous chunk is continued sequentially until it hits a
+	 * position where the speculative run also started a lexeme, and from there
+	 * the speculative lexemes are taken as they are. Tokens, lines, columns and
+	 * the first error are the same as with `tokenize()`.
+	 */
+	expected_value<std::vector<token_type>> tokenize_parallel(const std::size_t thread_count)
+	{
+		std::vector<token_type> tokens;
+		if (m_peek_buffer)
+		{
+			auto res = next();
+			if (!*res)
+			{
+				return std::unexpected(res->error());
+			}
+			tokens.emplace_back(**res);
+		}
+
+		const std::size_t begin = m_cursor;
+		const std::size_t chunk_count = std::min(thread_count, m_source.length() - begin);
+		if (chunk_count < 2)
+		{
+			auto rest = tokenize();
+			if (!rest)
+			{
+				return rest;
+			}
+			tokens.insert(tokens.end(), rest->begin(), rest->end());
+			return tokens;
+		}
+
+		const engine_t* engine = ensure_engine();
+
+		std::vector<std::size_t> bounds(chunk_count + 1);
+		for (std::size_t i = 0; i <= chunk_count; ++i)
+		{
+			bounds[i] = begin + (m_source.length() - begin) * i / chunk_count;
+		}
+
+		// Workers sharing counting prefilters would all write the same counters, so they count into copies instead.
+		std::vector<std::vector<rule>> worker_rules;
+		if constexpr (counting_prefilters)
+		{
+			if (std::ranges::any_of(m_rules, [](rule const& r) { return r.matcher.prefilter.counts_stats(); }))
+			{
+				worker_rules.assign(chunk_count - 1, m_rules);
+				for (auto const& rules : worker_rules)
+				{
+					std::ranges::for_each(rules, [](rule const& r) { r.matcher.prefilter.reset_stats(); });
+				}
+			}
+		}
+		const auto rules_of = [&](const std::size_t worker) -> std::span<const rule> {
+			return worker_rules.empty() ? std::span<const rule>(m_rules) : std::span<const rule>(worker_rules[worker - 1]);
+		};
+
+		std::vector<chunk_lexemes> chunks(chunk_count);
+		{
+			std::vector<std::jthread> workers;
+			workers.reserve(chunk_count - 1);
+			for (std::size_t i = 1; i < chunk_count; ++i)
+			{
+				workers.emplace_back([&, i] {
+					chunks[i] = lex_chunk(rules_of(i), engine, m_source, bounds[i], bounds[i + 1]);
+				});
+			}
+
+			chunks[0] = lex_chunk(m_rules, engine, m_source, bounds[0], bounds[1]);
+		}
+
+		if constexpr (counting_prefilters)
+		{
+			for (auto const& rules : worker_rules)
+			{
+				for (std::size_t k = 0; k < rules.size(); ++k)
+				{
+					m_rules[k].matcher.prefilter.add_stats(rules[k].matcher.prefilter.stats());
+				}
+			}
+		}
+
+		std::vector<lexeme_span> lexemes = std::move(chunks[0].lexemes);
+		std::size_t pos = chunks[0].end;
+		for (std::size_t i = 1; i < chunk_count; ++i)
+		{
+			auto const& chunk = chunks[i];
+			auto it = chunk.lexemes.begin();
+			while (pos < chunk.end)
+			{
+				it = std::ranges::lower_bound(it, chunk.lexemes.end(), pos, {}, &lexeme_span::offset);
+				if (it != chunk.lexemes.end() && it->offset == pos)
+				{
+					lexemes.insert(lexemes.end(), it, chunk.lexemes.end());
+					pos = chunk.end;
+					break;
+				}
+
+				lexemes.push_back(lex_one(m_rules, engine, m_source, pos));
+				pos += lexemes.back().length;
+			}
+		}
+
+		for (auto const& lexeme : lexemes)
+		{
+			move_cursor_to(lexeme.offset);
+			if (lexeme.rule_index == error_rule_index)
+			{
+				return std::unexpected(make_error_and_advance()->error());
+			}
+
+			auto const& matched_rule = m_rules[lexeme.rule_index];
+			if (!matched_rule.skip)
+			{
+				const auto position = tracked_position();
+				tokens.emplace_back(
+					matched_rule.type,
+					m_source.substr(lexeme.offset, lexeme.length),
+					position.line,
+					position.column,
+					lexeme.offset,
+					lexeme.length);
+			}
+		}
+		move_cursor_to(m_source.length());
+
+		return tokens;
+	}
+
+	/**
+	 * @brief Brings `old_tokens` up to date with `edit` without lexing the whole source again.
+	 *
+	 * The lexer source must already be the edited text. Lexing restarts one
+	 * token before the edit and stops as soon as a lexeme starts where an old
+	 * token started, past the edit; the remaining old tokens are then reused
+	 * with shifted offsets, lines and columns. Rules whose longest match looks
+	 * further back than one token are not supported. The lexer is left at the
+	 * end of the source.
+	 */
+	expected_value<std::vector<token_type>> relex(std::span<const token_type> old_tokens, source_edit const& edit)
+	{
+		auto restart = std::ranges::lower_bound(old_tokens, edit.offset, {}, [](token_type const& t) {
+			return t.offset + t.length;
+		});
+
+		m_peek_buffer.reset();
+		if (restart == old_tokens.begin())
+		{
+			m_cursor = 0;
+			m_line = 1;
+			m_column = 1;
+		}
+		else
+		{
+			--restart;
+			m_cursor = restart->offset;
+			m_line = restart->line;
+			m_column = restart->column;
+		}
+
+		std::vector<token_type> tokens;
+		tokens.reserve(old_tokens.size());
+		for (auto it = old_tokens.begin(); it != restart; ++it)
+		{
+			tokens.push_back(*it);
+			tokens.back().lexeme = m_source.substr(it->offset, it->length);
+		}
+
+		const std::size_t edit_end = edit.offset + edit.inserted.size();
+		const engine_t* engine = ensure_engine();
+		auto old_it = restart;
+		while (m_cursor < m_source.length())
+		{
+			if (m_cursor >= edit_end)
+			{
+				const std::size_t old_offset = m_cursor - edit.inserted.size() + edit.removed;
+				old_it = std::ranges::lower_bound(old_it, old_tokens.end(), old_offset, {}, &token_type::offset);
+				if (old_it != old_tokens.end() && old_it->offset == old_offset)
+				{
+					append_shifted(tokens, std::span(old_it, old_tokens.end()), edit);
+					break;
+				}
+			}
+
+			const auto lexeme = lex_one(m_rules, engine, m_source, m_cursor);
+			if (lexeme.rule_index == error_rule_index)
+			{
+				return std::unexpected(make_error_and_advance()->error());
+			}
+
+			auto const& matched_rule = m_rules[lexeme.rule_index];
+			const auto position = tracked_position();
+			advance_cursor(lexeme.length);
+			if (!matched_rule.skip)
+			{
+				tokens.emplace_back(
+					matched_rule.type,
+					m_source.substr(lexeme.offset, lexeme.length),
+					position.line,
+					position.column,
+					lexeme.offset,
+					lexeme.length);
+			}
+		}
+		move_cursor_to(m_source.length());
+
+		return tokens;
+	}
+
 private:
 	struct match_result
 	{
@@ -206,13 +807,33 @@ private:
 		std::size_t length{};
 	};
 
+	static constexpr std::size_t error_rule_index = static_cast<std::size_t>(-1);
+
+	struct lexeme_span
+	{
+		std::size_t rule_index{};
+		std::size_t offset{};
+		std::size_t length{};
+	};
+
+	struct chunk_lexemes
+	{
+		std::vector<lexeme_span> lexemes;
+		std::size_t end{};
+	};
+
 	std::string_view m_source;
 	std::vector<rule> m_rules;
+	std::optional<engine_t> m_engine;
 
 	std::size_t m_cursor = 0;
 	std::size_t m_line = 1;
 	std::size_t m_column = 1;
 
+	position_tracking m_tracking = position_tracking::eager;
+	column_unit m_columns = details::matcher_columns<T_Matcher>();
+	std::optional<line_index> m_lines;
+
 	result_type m_peek_buffer{};
 
 	result_type read_next_token()
@@ -226,8 +847,7 @@ private:
 				return make_error_and_advance();
 			}
 
-			std::size_t start_line = m_line;
-			std::size_t start_col = m_column;
+			const auto start_position = tracked_position();
 			std::size_t start_offset = m_cursor;
 
 			advance_cursor(match->length);
@@ -240,8 +860,8 @@ private:
 			return token_type{
 				match->matched_rule->type,
 				m_source.substr(start_offset, match->length),
-				start_line,
-				start_col,
+				start_position.line,
+				start_position.column,
 				start_offset,
 				match->length
 			};
@@ -250,38 +870,217 @@ private:
 		return std::nullopt;
 	}
 
+	// Appends the old tokens following a resync point; the cursor is at the first of them.
+	void append_shifted(std::vector<token_type>& tokens, std::span<const token_type> tail, source_edit const& edit) const
+	{
+		const auto sync = tracked_position();
+		const std::size_t old_line = tail.front().line;
+		const std::size_t old_column = tail.front().column;
+
+		for (auto const& old : tail)
+		{
+			auto& shifted = tokens.emplace_back(old);
+			shifted.offset = old.offset - edit.removed + edit.inserted.size();
+			shifted.lexeme = m_source.substr(shifted.offset, shifted.length);
+			if (m_tracking == position_tracking::eager)
+			{
+				shifted.line = old.line - old_line + sync.line;
+				if (old.line == old_line)
+				{
+					shifted.column = old.column - old_column + sync.column;
+				}
+			}
+		}
+	}
+
+	// Lexes without per-token line tracking; the cursor position is brought up to date once at the end.
+	template <typename T_Flush>
+	expected_value<std::size_t> fill_buffer(token_buffer<T_TokenType>& out, T_Flush flush)
+	{
+		std::size_t count = 0;
+		const auto has_room = [&] { return !out.full() || flush(out); };
+
+		if (m_peek_buffer)
+		{
+			if (!has_room())
+			{
+				return count;
+			}
+
+			auto res = next();
+			if (!*res)
+			{
+				return std::unexpected(res->error());
+			}
+			out.push_back((*res)->type, (*res)->offset, (*res)->length);
+			count++;
+		}
+
+		const engine_t* engine = ensure_engine();
+		std::size_t pos = m_cursor;
+		while (pos < m_source.length())
+		{
+			const auto lexeme = lex_one(m_rules, engine, m_source, pos);
+			if (lexeme.rule_index == error_rule_index)
+			{
+				move_cursor_to(pos);
+				return std::unexpected(make_error_and_advance()->error());
+			}
+
+			auto const& matched_rule = m_rules[lexeme.rule_index];
+			if (!matched_rule.skip)
+			{
+				if (!has_room())
+				{
+					break;
+				}
+				out.push_back(matched_rule.type, pos, lexeme.length);
+				count++;
+			}
+			pos += lexeme.length;
+		}
+		move_cursor_to(pos);
+
+		return count;
+	}
+
+	const engine_t* ensure_engine()
+	{
+		if constexpr (concepts::combined_matcher<T_Matcher>)
+		{
+			if (!m_engine)
+			{
+				m_engine.emplace(m_rules | std::views::transform(&rule::matcher));
+			}
+
+			return &*m_engine;
+		}
+		else
+		{
+			return nullptr;
+		}
+	}
+
 	std::optional<match_result> find_longest_match()
 	{
-		const rule* best_rule = nullptr;
-		std::size_t max_len = 0;
+		return match_at(m_rules, ensure_engine(), m_source, m_cursor);
+	}
 
-		for (const auto& rule : m_rules)
+	static std::optional<match_result> match_at(
+		std::span<const rule> rules,
+		const engine_t* engine,
+		const std::string_view source,
+		const std::size_t pos)
+	{
+		if constexpr (concepts::combined_matcher<T_Matcher>)
 		{
-			if (const std::size_t current_len = rule.matcher.find_match(m_source, m_cursor); current_len > max_len)
+			if (const auto match = engine->longest_match(source, pos))
 			{
-				max_len = current_len;
-				best_rule = &rule;
+				return match_result{ &rules[match->rule_index], match->length };
 			}
+
+			return std::nullopt;
 		}
+		else
+		{
+			const rule* best_rule = nullptr;
+			std::size_t max_len = 0;
 
-		if (max_len > 0)
+			for (const auto& rule : rules)
+			{
+				if (const std::size_t current_len = rule.matcher.find_match(source, pos); current_len > max_len)
+				{
+					max_len = current_len;
+					best_rule = &rule;
+				}
+			}
+
+			if (max_len > 0)
+			{
+				return match_result{ best_rule, max_len };
+			}
+
+			return std::nullopt;
+		}
+	}
+
+	static lexeme_span lex_one(
+		std::span<const rule> rules,
+		const engine_t* engine,
+		const std::string_view source,
+		const std::size_t pos)
+	{
+		if (const auto match = match_at(rules, engine, source, pos))
 		{
-			return match_result{ best_rule, max_len };
+			return { static_cast<std::size_t>(match->matched_rule - rules.data()), pos, match->length };
 		}
 
-		return std::nullopt;
+		return { error_rule_index, pos, 1 };
+	}
+
+	static constexpr bool counting_prefilters = requires(T_Matcher const& matcher) { matcher.prefilter.counts_stats(); };
+
+	static chunk_lexemes lex_chunk(
+		std::span<const rule> rules,
+		const engine_t* engine,
+		const std::string_view source,
+		std::size_t pos,
+		const std::size_t stop)
+	{
+		chunk_lexemes chunk;
+		while (pos < stop)
+		{
+			chunk.lexemes.push_back(lex_one(rules, engine, source, pos));
+			pos += chunk.lexemes.back().length;
+		}
+		chunk.end = pos;
+
+		return chunk;
+	}
+
+	// Same as advance_cursor, but counts newlines over the whole range at once.
+	void move_cursor_to(const std::size_t target)
+	{
+		if (m_tracking == position_tracking::lazy)
+		{
+			m_cursor = target;
+			return;
+		}
+
+		const auto range = m_source.substr(m_cursor, target - m_cursor);
+		if (const auto newlines = static_cast<std::size_t>(std::ranges::count(range, '\n')); newlines > 0)
+		{
+			m_line += newlines;
+			m_column = column_width(range.substr(range.rfind('\n') + 1), m_columns) + 1;
+		}
+		else
+		{
+			m_column += column_width(range, m_columns);
+		}
+		m_cursor = target;
+	}
+
+	[[nodiscard]] source_position tracked_position() const
+	{
+		return m_tracking == position_tracking::eager ? source_position{ m_line, m_column } : source_position{};
 	}
 
 	void advance_cursor(const size_t length)
 	{
+		if (m_tracking == position_tracking::lazy)
+		{
+			m_cursor += length;
+			return;
+		}
+
 		for (std::size_t i = 0; i < length; ++i)
 		{
-			if (m_source[m_cursor] == '\n')
+			if (const char ch = m_source[m_cursor]; ch == '\n')
 			{
 				++m_line;
 				m_column = 1;
 			}
-			else
+			else if (m_columns == column_unit::bytes || (static_cast<unsigned char>(ch) & 0xC0) != 0x80)
 			{
 				++m_column;
 			}
@@ -291,9 +1090,11 @@ private:
 
 	result_type make_error_and_advance()
 	{
+		const auto position = m_tracking == position_tracking::eager ? tracked_position() : lines().at(m_cursor, m_columns);
+
 		const auto err = std::unexpected(lexer_error{
-			m_line,
-			m_column,
+			position.line,
+			position.column,
 			m_cursor,
 			m_source[m_cursor],
 		});
@@ -0,0 +1,427 @@
+#ifndef FSM_LEXER_CACHE_HPP
+#define FSM_LEXER_CACHE_HPP
+
+#include "byte_dfa.hpp"
+#include "lexer.hpp"
+#include "mapped_source.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fsm
+{
+inline constexpr std::uint32_t lexer_cache_version = 1;
+
+namespace details
+{
+inline constexpr char lexer_cache_magic[8] = { 'F', 'S', 'M', 'L', 'E', 'X', 'C', '\0' };
+inline constexpr std::uint32_t lexer_cache_endian_tag = 0x01020304;
+
+/*
+ * File layout, all integers in native byte order:
+ *   header
+ *   uint8  byte_classes[256]
+ *   uint32 transitions[state_count * class_count]
+ *   uint32 accept_tags[state_count]
+ *   rule_count x { uint32 skip, uint32 pattern_size, uint32 type_size, pattern, type, padding to 4 }
+ */
+struct lexer_cache_header
+{
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t endian_tag;
+	std::uint64_t rules_hash;
+	std::uint64_t payload_checksum;
+	std::uint64_t payload_size;
+	std::uint32_t state_count;
+	std::uint32_t class_count;
+	std::uint32_t start_state;
+	std::uint32_t rule_count;
+};
+
+static_assert(sizeof(lexer_cache_header) % alignof(std::uint64_t) == 0);
+
+class fnv1a
+{
+public:
+	void update(const void* data, const std::size_t size)
+	{
+		const auto* bytes = static_cast<const unsigned char*>(data);
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			m_hash = (m_hash ^ bytes[i]) * 1099511628211ull;
+		}
+	}
+
+	void update(const std::string_view text)
+	{
+		update_value(static_cast<std::uint64_t>(text.size()));
+		update(text.data(), text.size());
+	}
+
+	template <typename T>
+	void update_value(const T value)
+	{
+		update(&value, sizeof(value));
+	}
+
+	[[nodiscard]] std::uint64_t value() const
+	{
+		return m_hash;
+	}
+
+private:
+	std::uint64_t m_hash = 14695981039346656037ull;
+};
+
+template <typename T_TokenType>
+std::string token_type_bytes(T_TokenType const& type)
+{
+	if constexpr (std::is_convertible_v<T_TokenType const&, std::string_view>)
+	{
+		return std::string(std::string_view(type));
+	}
+	else if constexpr (std::is_integral_v<T_TokenType> || std::is_enum_v<T_TokenType>)
+	{
+		std::string bytes(sizeof(T_TokenType), '\0');
+		std::memcpy(bytes.data(), &type, sizeof(T_TokenType));
+		return bytes;
+	}
+	else
+	{
+		static_assert(sizeof(T_TokenType) == 0, "Token type is not serializable. It must be string-like, integral or an enum.");
+	}
+}
+
+template <typename T>
+void append_bytes(std::string& out, const T* data, const std::size_t count)
+{
+	out.append(reinterpret_cast<const char*>(data), count * sizeof(T));
+}
+} // namespace details
+
+/**
+ * @brief Hash of everything a compiled lexer depends on: rule patterns, types, skip flags and their order.
+ */
+template <typename T_Rules>
+std::uint64_t lexer_rules_hash(T_Rules const& rules)
+{
+	details::fnv1a hash;
+	hash.update_value(lexer_cache_version);
+	hash.update_value(static_cast<std::uint64_t>(std::ranges::size(rules)));
+
+	for (auto const& rule : rules)
+	{
+		hash.update(rule.matcher.pattern);
+		hash.update(details::token_type_bytes(rule.type));
+		hash.update_value(static_cast<std::uint8_t>(rule.skip));
+	}
+
+	return hash.value();
+}
+
+template <typename T_TokenType>
+void save_lexer_cache(lexer<T_TokenType, combined_dfa_matcher>& lex, std::ostream& os)
+{
+	const auto dfa = lex.engine().dfa();
+	auto const& rules = lex.rules();
+
+	std::string payload;
+	details::append_bytes(payload, dfa.byte_classes, 256);
+	details::append_bytes(payload, dfa.transitions, dfa.state_count() * dfa.class_count);
+	details::append_bytes(payload, dfa.accept_tags, dfa.state_count());
+
+	for (auto const& rule : rules)
+	{
+		const auto type = details::token_type_bytes(rule.type);
+		const std::uint32_t fields[] = {
+			rule.skip,
+			static_cast<std::uint32_t>(rule.matcher.pattern.size()),
+			static_cast<std::uint32_t>(type.size()),
+		};
+
+		details::append_bytes(payload, fields, std::size(fields));
+		payload += rule.matcher.pattern;
+		payload += type;
+		payload.resize((payload.size() + 3) / 4 * 4, '\0');
+	}
+
+	details::fnv1a checksum;
+	checksum.update(payload.data(), payload.size());
+
+	details::lexer_cache_header header{};
+	std::memcpy(header.magic, details::lexer_cache_magic, sizeof(header.magic));
+	header.version = lexer_cache_version;
+	header.endian_tag = details::lexer_cache_endian_tag;
+	header.rules_hash = lexer_rules_hash(rules);
+	header.payload_checksum = checksum.value();
+	header.payload_size = payload.size();
+	header.state_count = static_cast<std::uint32_t>(dfa.state_count());
+	header.class_count = dfa.class_count;
+	header.start_state = dfa.start_state;
+	header.rule_count = static_cast<std::uint32_t>(rules.size());
+
+	os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	os.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+}
+
+/**
+ * @brief A validated, zero-copy view of a lexer cache file.
+ *
+ * The transition tables are used in place, so the bytes (typically a
+ * `mapped_source`) must outlive the view and every engine made from it.
+ */
+class lexer_cache_view
+{
+public:
+	struct rule_record
+	{
+		std::string_view pattern;
+		std::string_view type;
+
+		bool skip{};
+	};
+
+	/// Returns nothing if the bytes are not a complete, intact cache of this version.
+	static std::optional<lexer_cache_view> open(const std::string_view bytes)
+	{
+		using header_t = details::lexer_cache_header;
+
+		if (bytes.size() < sizeof(header_t) || reinterpret_cast<std::uintptr_t>(bytes.data()) % alignof(std::uint32_t) != 0)
+		{
+			return std::nullopt;
+		}
+
+		lexer_cache_view view;
+		std::memcpy(&view.m_header, bytes.data(), sizeof(header_t));
+
+		auto const& header = view.m_header;
+		if (std::memcmp(header.magic, details::lexer_cache_magic, sizeof(header.magic)) != 0
+			|| header.version != lexer_cache_version
+			|| header.endian_tag != details::lexer_cache_endian_tag
+			|| header.payload_size != bytes.size() - sizeof(header_t)
+			|| header.state_count == 0
+			|| header.class_count == 0
+			|| header.class_count > 256
+			|| header.start_state >= header.state_count)
+		{
+			return std::nullopt;
+		}
+
+		const std::string_view payload = bytes.substr(sizeof(header_t));
+
+		details::fnv1a checksum;
+		checksum.update(payload.data(), payload.size());
+		if (checksum.value() != header.payload_checksum)
+		{
+			return std::nullopt;
+		}
+
+		const std::size_t transition_count = std::size_t{ header.state_count } * header.class_count;
+		const std::size_t tables_size = 256 + (transition_count + header.state_count) * sizeof(std::uint32_t);
+		if (payload.size() < tables_size)
+		{
+			return std::nullopt;
+		}
+
+		auto& dfa = view.m_dfa;
+		dfa.byte_classes = reinterpret_cast<const std::uint8_t*>(payload.data());
+		dfa.class_count = header.class_count;
+		dfa.transitions = reinterpret_cast<const std::uint32_t*>(payload.data() + 256);
+		dfa.accept_tags = dfa.transitions + transition_count;
+		dfa.states = header.state_count;
+		dfa.start_state = header.start_state;
+
+		for (std::size_t byte = 0; byte < 256; ++byte)
+		{
+			if (dfa.byte_classes[byte] >= header.class_count)
+			{
+				return std::nullopt;
+			}
+		}
+
+		for (std::size_t i = 0; i < transition_count; ++i)
+		{
+			if (dfa.transitions[i] >= header.state_count)
+			{
+				return std::nullopt;
+			}
+		}
+
+		for (std::size_t state = 0; state < header.state_count; ++state)
+		{
+			if (dfa.accept_tags[state] > header.rule_count)
+			{
+				return std::nullopt;
+			}
+		}
+
+		std::size_t pos = tables_size;
+		for (std::uint32_t i = 0; i < header.rule_count; ++i)
+		{
+			std::uint32_t fields[3];
+			if (payload.size() - pos < sizeof(fields))
+			{
+				return std::nullopt;
+			}
+			std::memcpy(fields, payload.data() + pos, sizeof(fields));
+			pos += sizeof(fields);
+
+			if (payload.size() - pos < std::size_t{ fields[1] } + fields[2])
+			{
+				return std::nullopt;
+			}
+
+			view.m_rules.push_back({
+				payload.substr(pos, fields[1]),
+				payload.substr(pos + fields[1], fields[2]),
+				fields[0] != 0,
+			});
+			pos = (pos + fields[1] + fields[2] + 3) / 4 * 4;
+		}
+
+		return view;
+	}
+
+	[[nodiscard]] std::uint64_t rules_hash() const
+	{
+		return m_header.rules_hash;
+	}
+
+	[[nodiscard]] byte_dfa_view dfa() const
+	{
+		return m_dfa;
+	}
+
+	[[nodiscard]] std::vector<rule_record> const& rules() const
+	{
+		return m_rules;
+	}
+
+private:
+	details::lexer_cache_header m_header{};
+	byte_dfa_view m_dfa;
+	std::vector<rule_record> m_rules;
+};
+
+/**
+ * @brief A combined-DFA rule set backed by an on-disk cache of its automaton.
+ *
+ * `load_or_build` maps the cache file and uses its tables in place when it was
+ * built from exactly the given rules (same `lexer_rules_hash`); otherwise the
+ * rules are compiled and the cache is rewritten. Lexers made by `make_lexer`
+ * share the tables and must not outlive the `cached_lexer`.
+ */
+template <typename T_TokenType>
+class cached_lexer
+{
+public:
+	using lexer_type = lexer<T_TokenType, combined_dfa_matcher>;
+	using rule = typename lexer_type::rule;
+
+	static cached_lexer load_or_build(std::filesystem::path const& path, std::vector<rule> rules)
+	{
+		if (auto cached = try_load(path, lexer_rules_hash(rules)))
+		{
+			auto dfa = cached->second.dfa();
+			return cached_lexer(std::move(cached->first), std::move(rules), engine_t(dfa));
+		}
+
+		lexer_type builder({}, rules);
+		auto engine = builder.engine();
+		store(path, builder);
+
+		return cached_lexer(std::nullopt, std::move(rules), std::move(engine));
+	}
+
+	[[nodiscard]] lexer_type make_lexer(const std::string_view source = {}) const
+	{
+		lexer_type lex(source, m_rules);
+		lex.with_engine(m_engine);
+
+		return lex;
+	}
+
+	[[nodiscard]] bool loaded_from_cache() const
+	{
+		return m_mapping.has_value();
+	}
+
+	[[nodiscard]] std::vector<rule> const& rules() const
+	{
+		return m_rules;
+	}
+
+private:
+	using engine_t = typename combined_dfa_matcher::engine_type;
+
+	std::optional<mapped_source> m_mapping;
+	std::vector<rule> m_rules;
+	engine_t m_engine;
+
+	cached_lexer(std::optional<mapped_source> mapping, std::vector<rule> rules, engine_t engine)
+		: m_mapping{ std::move(mapping) }
+		, m_rules{ std::move(rules) }
+		, m_engine{ std::move(engine) }
+	{
+	}
+
+	static std::optional<std::pair<mapped_source, lexer_cache_view>>
+	try_load(std::filesystem::path const& path, const std::uint64_t rules_hash)
+	{
+		std::error_code ec;
+		if (!std::filesystem::is_regular_file(path, ec))
+		{
+			return std::nullopt;
+		}
+
+		try
+		{
+			mapped_source mapping(path);
+			auto view = lexer_cache_view::open(mapping.view());
+			if (!view || view->rules_hash() != rules_hash)
+			{
+				return std::nullopt;
+			}
+
+			return std::pair{ std::move(mapping), std::move(*view) };
+		}
+		catch (std::runtime_error const&)
+		{
+			return std::nullopt;
+		}
+	}
+
+	// The cache is an optimization only: failing to write it is not an error.
+	static void store(std::filesystem::path const& path, lexer_type& builder)
+	{
+		auto temporary = path;
+		temporary += ".tmp";
+
+		{
+			std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+			if (!out)
+			{
+				return;
+			}
+			save_lexer_cache(builder, out);
+			if (!out)
+			{
+				return;
+			}
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(temporary, path, ec);
+	}
+};
+} // namespace fsm
+
+#endif // FSM_LEXER_CACHE_HPP
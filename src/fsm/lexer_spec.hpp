@@ -0,0 +1,183 @@
+#ifndef FSM_LEXER_SPEC_HPP
+#define FSM_LEXER_SPEC_HPP
+
+#include "concepts.hpp"
+#include "lexer.hpp"
+#include "mapped_source.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iostream>
+#include <istream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fsm
+{
+struct lexer_spec_entry
+{
+	std::string name;
+	std::string pattern;
+
+	bool skip{};
+	std::size_t line{};
+};
+
+/**
+ * Expected format, one rule per line, earlier rules win on equal match length:
+ * NAME pattern
+ * %skip NAME pattern
+ * # comment
+ *
+ * The pattern is the rest of the line after the name.
+ */
+inline std::vector<lexer_spec_entry> lexer_spec_parse(std::istream& in)
+{
+	std::vector<lexer_spec_entry> entries;
+
+	std::string line;
+	std::size_t line_num = 0;
+	while (std::getline(in, line))
+	{
+		line_num++;
+		const std::string clean_line = utility::trim(line);
+		if (clean_line.empty() || clean_line[0] == '#')
+		{
+			continue;
+		}
+
+		std::istringstream ss(clean_line);
+		lexer_spec_entry entry;
+		entry.line = line_num;
+		ss >> entry.name;
+
+		if (entry.name == "%skip")
+		{
+			entry.skip = true;
+			entry.name.clear();
+			ss >> entry.name;
+		}
+		else if (entry.name.starts_with('%'))
+		{
+			throw std::runtime_error("Syntax error at line " + std::to_string(line_num) + ": unknown directive '" + entry.name + "'");
+		}
+
+		std::getline(ss >> std::ws, entry.pattern);
+		if (entry.name.empty() || entry.pattern.empty())
+		{
+			throw std::runtime_error("Syntax error at line " + std::to_string(line_num) + ": expected 'NAME pattern'");
+		}
+
+		entries.push_back(std::move(entry));
+	}
+
+	return entries;
+}
+
+/**
+ * @brief Loads a lexer rule file into rules ready for `lexer(source, rules)`.
+ *
+ * Every distinct pattern is compiled once, whichever rules share it, and the
+ * compilations are spread over `thread_count` threads. Rule order is kept.
+ */
+template <
+	concepts::is_std_string_constructible T_TokenType = std::string,
+	typename T_Matcher = fsm_regex_matcher>
+std::vector<typename lexer<T_TokenType, T_Matcher>::rule>
+lexer_spec_load(std::istream& in = std::cin, const std::size_t thread_count = std::thread::hardware_concurrency())
+{
+	using rule_type = typename lexer<T_TokenType, T_Matcher>::rule;
+
+	const auto entries = lexer_spec_parse(in);
+
+	std::map<std::string_view, std::size_t> pattern_ids;
+	std::vector<std::size_t> first_use;
+	std::vector<std::size_t> entry_pattern;
+	for (std::size_t i = 0; i < entries.size(); ++i)
+	{
+		const auto [it, inserted] = pattern_ids.try_emplace(entries[i].pattern, first_use.size());
+		if (inserted)
+		{
+			first_use.push_back(i);
+		}
+		entry_pattern.push_back(it->second);
+	}
+
+	std::vector<std::optional<T_Matcher>> matchers(first_use.size());
+	std::vector<std::exception_ptr> errors(first_use.size());
+	std::atomic<std::size_t> next_pattern = 0;
+
+	const auto compile_patterns = [&] {
+		for (std::size_t id = next_pattern++; id < first_use.size(); id = next_pattern++)
+		{
+			try
+			{
+				matchers[id].emplace(T_Matcher::compile(entries[first_use[id]].pattern));
+			}
+			catch (...)
+			{
+				errors[id] = std::current_exception();
+			}
+		}
+	};
+
+	{
+		const std::size_t workers_count = std::min(std::max<std::size_t>(thread_count, 1), first_use.size());
+		std::vector<std::jthread> workers;
+		for (std::size_t i = 1; i < workers_count; ++i)
+		{
+			workers.emplace_back(compile_patterns);
+		}
+		compile_patterns();
+	}
+
+	for (std::size_t id = 0; id < errors.size(); ++id)
+	{
+		if (!errors[id])
+		{
+			continue;
+		}
+
+		const auto line_num = std::to_string(entries[first_use[id]].line);
+		try
+		{
+			std::rethrow_exception(errors[id]);
+		}
+		catch (std::exception const& e)
+		{
+			throw std::runtime_error("Invalid pattern at line " + line_num + ": " + e.what());
+		}
+		catch (...)
+		{
+			throw std::runtime_error("Invalid pattern at line " + line_num);
+		}
+	}
+
+	std::vector<rule_type> rules;
+	rules.reserve(entries.size());
+	for (std::size_t i = 0; i < entries.size(); ++i)
+	{
+		rules.push_back(rule_type{ T_TokenType(entries[i].name), *matchers[entry_pattern[i]], entries[i].skip });
+	}
+
+	return rules;
+}
+
+template <
+	concepts::is_std_string_constructible T_TokenType = std::string,
+	typename T_Matcher = fsm_regex_matcher>
+std::vector<typename lexer<T_TokenType, T_Matcher>::rule>
+lexer_spec_load(mapped_source const& source, const std::size_t thread_count = std::thread::hardware_concurrency())
+{
+	auto in = source.stream();
+	return lexer_spec_load<T_TokenType, T_Matcher>(in, thread_count);
+}
+} // namespace fsm
+
+#endif // FSM_LEXER_SPEC_HPP
@@ -0,0 +1,96 @@
+#ifndef FSM_LINE_INDEX_HPP
+#define FSM_LINE_INDEX_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace fsm
+{
+struct source_position
+{
+	std::size_t line{};
+	std::size_t column{};
+
+	bool operator==(source_position const&) const = default;
+};
+
+/// What a column counts: bytes, or UTF-8 code points (bytes that are not continuation bytes).
+enum class column_unit
+{
+	bytes,
+	code_points
+};
+
+/// Number of columns `text` spans.
+inline std::size_t column_width(const std::string_view text, const column_unit unit)
+{
+	if (unit == column_unit::bytes)
+	{
+		return text.length();
+	}
+
+	return static_cast<std::size_t>(std::ranges::count_if(text, [](const char ch) {
+		return (static_cast<unsigned char>(ch) & 0xC0) != 0x80;
+	}));
+}
+
+/**
+ * @brief Offsets of every newline of a source, for turning offsets into line/column.
+ *
+ * The newlines are collected once with `memchr`, which the standard library
+ * vectorizes; a lookup is then a binary search. Lines and columns are 1-based;
+ * code point columns are counted from the line start at lookup time. The index
+ * keeps a view of the source, which must outlive it.
+ */
+class line_index
+{
+public:
+	line_index() = default;
+
+	explicit line_index(const std::string_view source)
+		: m_source{ source }
+	{
+		const char* const begin = source.data();
+		const char* const end = begin + source.size();
+		for (const char* it = begin; it != end;)
+		{
+			const void* found = std::memchr(it, '\n', static_cast<std::size_t>(end - it));
+			if (!found)
+			{
+				break;
+			}
+
+			const auto* newline = static_cast<const char*>(found);
+			m_newlines.push_back(static_cast<std::size_t>(newline - begin));
+			it = newline + 1;
+		}
+	}
+
+	[[nodiscard]] source_position at(const std::size_t offset, const column_unit unit = column_unit::bytes) const
+	{
+		const auto it = std::ranges::lower_bound(m_newlines, offset);
+		const std::size_t line = static_cast<std::size_t>(it - m_newlines.begin());
+		const std::size_t line_start = line == 0 ? 0 : m_newlines[line - 1] + 1;
+
+		return { line + 1, column_width(m_source.substr(line_start, offset - line_start), unit) + 1 };
+	}
+
+	[[nodiscard]] std::size_t line_count() const
+	{
+		return m_newlines.size() + 1;
+	}
+
+	[[nodiscard]] std::size_t source_size() const
+	{
+		return m_source.size();
+	}
+
+private:
+	std::vector<std::size_t> m_newlines;
+	std::string_view m_source;
+};
+} // namespace fsm
+
+#endif // FSM_LINE_INDEX_HPP
@@ -0,0 +1,159 @@
+#ifndef FSM_LR_AST_BUILDER_HPP
+#define FSM_LR_AST_BUILDER_HPP
+
+#include "semantic_parser.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace fsm::lr
+{
+/**
+ * @brief A node of a tree built by `lr::ast_builder`.
+ *
+ * Leaves are shifted tokens and have no rule. `token_index` is the leaf's
+ * token, or the first token covered by an inner node.
+ */
+struct ast_node
+{
+	static constexpr std::uint32_t no_rule = static_cast<std::uint32_t>(-1);
+
+	std::uint32_t rule_index = no_rule;
+	std::size_t token_index{};
+	std::span<const ast_node* const> children;
+
+	[[nodiscard]] bool is_leaf() const
+	{
+		return rule_index == no_rule;
+	}
+};
+
+/**
+ * @brief Builds an `ast_node` tree for every parse out of one memory block.
+ *
+ * Nodes and child arrays are carved from a monotonic arena over a buffer that
+ * grows to the largest tree seen so far, so a steady stream of parses does
+ * not allocate. A tree is valid until the next `parse`.
+ *
+ * Reductions by a skipped rule with a single symbol reuse the child node
+ * instead of creating one, which removes chains like `E -> T -> F`.
+ */
+template <typename T_Table>
+class ast_builder
+{
+public:
+	using table_type = T_Table;
+	using symbol_type = typename table_type::symbol_type;
+	using error_type = event_error<symbol_type>;
+
+	explicit ast_builder(const table_type& tbl)
+		: m_table{ tbl }
+		, m_parser{ tbl }
+		, m_skipped(tbl.rules().size(), false)
+	{
+		m_parser
+			.on_shift([this](const symbol_type&, const std::size_t token_index) {
+				return make_node(ast_node::no_rule, token_index, {});
+			})
+			.on_default_reduce([this](const event_record& reduce, std::span<const ast_node*> rhs) {
+				if (rhs.size() == 1 && m_skipped[reduce.rule_index])
+				{
+					return rhs.front();
+				}
+
+				return make_node(reduce.rule_index, rhs.empty() ? reduce.token_index : rhs.front()->token_index, rhs);
+			});
+	}
+
+	// The callbacks hold `this`.
+	ast_builder(const ast_builder&) = delete;
+	ast_builder& operator=(const ast_builder&) = delete;
+
+	ast_builder& skip_rule(const cfg_rule<symbol_type>& rule)
+	{
+		const auto it = std::ranges::find(m_table.rules(), rule);
+		if (it == m_table.rules().end())
+		{
+			throw std::invalid_argument("Rule is not in the table");
+		}
+
+		m_skipped[static_cast<std::size_t>(it - m_table.rules().begin())] = true;
+
+		return *this;
+	}
+
+	/// Skips every rule of the form `A -> B` where `B` is a non-terminal.
+	ast_builder& skip_unit_rules()
+	{
+		const auto& non_terminals = m_table.non_terminals();
+		for (std::size_t i = 0; i < m_table.rules().size(); ++i)
+		{
+			const auto& rhs = m_table.rule(i).rhs;
+			if (rhs.size() == 1 && std::ranges::find(non_terminals, rhs.front()) != non_terminals.end())
+			{
+				m_skipped[i] = true;
+			}
+		}
+
+		return *this;
+	}
+
+	std::expected<const ast_node*, error_type> parse(std::span<const symbol_type> input)
+	{
+		// A leaf and about one inner node with two children per token, or more if a previous tree needed it.
+		const std::size_t estimate = input.size() * (2 * sizeof(ast_node) + 3 * sizeof(const ast_node*)) + sizeof(ast_node);
+		if (const std::size_t wanted = std::max(estimate, m_bytes_used + m_bytes_used / 2); wanted > m_buffer.size())
+		{
+			m_buffer.resize(wanted);
+		}
+
+		m_bytes_used = 0;
+		m_arena.emplace(m_buffer.data(), m_buffer.size());
+
+		return m_parser.parse(input);
+	}
+
+	/// Bytes of nodes and child arrays of the last tree.
+	[[nodiscard]] std::size_t bytes_used() const
+	{
+		return m_bytes_used;
+	}
+
+private:
+	const table_type& m_table;
+	semantic_parser<const ast_node*, table_type> m_parser;
+	std::vector<bool> m_skipped;
+
+	std::vector<std::byte> m_buffer;
+	std::optional<std::pmr::monotonic_buffer_resource> m_arena;
+	std::size_t m_bytes_used = 0;
+
+	const ast_node* make_node(const std::uint32_t rule_index, const std::size_t token_index, std::span<const ast_node*> rhs)
+	{
+		std::span<const ast_node* const> children;
+		if (!rhs.empty())
+		{
+			auto* array = static_cast<const ast_node**>(allocate(rhs.size_bytes(), alignof(const ast_node*)));
+			std::ranges::copy(rhs, array);
+			children = { array, rhs.size() };
+		}
+
+		return new (allocate(sizeof(ast_node), alignof(ast_node))) ast_node{ rule_index, token_index, children };
+	}
+
+	void* allocate(const std::size_t bytes, const std::size_t alignment)
+	{
+		m_bytes_used += bytes + alignment - 1;
+
+		return m_arena->allocate(bytes, alignment);
+	}
+};
+} // namespace fsm::lr
+
+#endif // FSM_LR_AST_BUILDER_HPP
@@ -1,13 +1,21 @@
 #ifndef FSM_LR_BASIC_TABLE_BUILDER_HPP
 #define FSM_LR_BASIC_TABLE_BUILDER_HPP
 
+#include "../cfg/cfg_algorithms.hpp"
 #include "../utility.hpp"
+#include "compact_table.hpp"
+#include "item_grammar.hpp"
 #include "lr0_item.hpp"
 #include "table.hpp"
 
+#include <algorithm>
 #include <format>
 #include <functional>
+#include <map>
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace fsm::lr
 {
@@ -41,8 +49,16 @@ FSM_LR_EMPTY_TYPE(strict_t);
 FSM_LR_EMPTY_TYPE(prefer_shift_t);
 FSM_LR_EMPTY_TYPE(keep_first_t);
 FSM_LR_EMPTY_TYPE(keep_last_t);
+FSM_LR_EMPTY_TYPE(keep_all_t);
 
 #undef FSM_LR_EMPTY_TYPE
+
+/// Kernel item `to_item_index` of `to_state` inherits the lookaheads of the item the edge is stored under.
+struct propagation_edge
+{
+	std::size_t to_state;
+	std::size_t to_item_index;
+};
 } // namespace detail
 
 namespace collision_policy
@@ -51,6 +67,8 @@ inline constexpr detail::strict_t strict{};
 inline constexpr detail::prefer_shift_t prefer_shift{};
 inline constexpr detail::keep_first_t keep_first{};
 inline constexpr detail::keep_last_t keep_last{};
+/// Keeps the first action in the cell and the others as `table::conflicting_actions`, for `glr::parser`.
+inline constexpr detail::keep_all_t keep_all{};
 } // namespace collision_policy
 
 template <typename T_Derived, typename T_Symbol, typename T_Compare = std::less<T_Symbol>>
@@ -60,7 +78,7 @@ class basic_table_builder
 
 public:
 	using grammar_t = basic_cfg<T_Symbol, T_Compare>;
-	using item_t = lr0_item<T_Symbol>;
+	using item_t = lr0_item;
 	using state_t = std::set<item_t>;
 	using identity_symbol = std::type_identity_t<T_Symbol>;
 	using action_type = table_t::action_type;
@@ -69,6 +87,7 @@ public:
 public:
 	using grammar_type = grammar_t;
 	using table_type = table_t;
+	using compact_table_type = compact_table<T_Symbol, T_Compare>;
 	using warning_callback_type = std::function<void(const std::string&)>;
 
 	basic_table_builder() = delete;
@@ -161,7 +180,7 @@ protected:
 				[&](const action_error&) { return true; },
 				[&](const action_accept&) { return true; },
 				[&](const action_shift<state_id_t>& s1) { return s1.target_state == actions::as_shift(b).target_state; },
-				[&](const action_reduce<T_Symbol>& r1) { return r1.rule == actions::as_reduce(b).rule; });
+				[&](const action_reduce& r1) { return r1 == actions::as_reduce(b); });
 		};
 
 		if (is_same_action(existing, new_action))
@@ -200,10 +219,296 @@ protected:
 			[&](detail::keep_last_t) {
 				call_warning("[WARNING] " + msg + " -> Resolved: Keep Last.");
 				out_table.add_action(state_id, terminal, new_action);
+			},
+			[&](detail::keep_all_t) {
+				call_warning("[WARNING] " + msg + " -> Resolved: Keep All.");
+				out_table.add_conflict(state_id, terminal, new_action);
 			}
 		}(policy);
 	}
 
+	using lookaheads_t = std::set<T_Symbol, T_Compare>;
+	using lr1_state_t = std::map<item_t, lookaheads_t>;
+	using first_sets_t = std::map<T_Symbol, lookaheads_t, T_Compare>;
+	using item_grammar_t = detail::item_grammar<T_Symbol, T_Compare>;
+	using kernel_t = detail::item_kernel;
+	using transitions_t = std::map<std::pair<std::size_t, T_Symbol>, std::size_t>;
+
+	/// Lookaheads of an item closed over a kernel item with the unknown lookahead `#`.
+	struct marked_lookaheads
+	{
+		lookaheads_t symbols;
+		bool propagated = false;
+	};
+
+	item_grammar_t make_item_grammar() const
+	{
+		return item_grammar_t(m_grammar, m_epsilon, m_aug_start);
+	}
+
+	/// FIRST of what follows the next symbol of `item`, and whether all of it can derive ε.
+	std::pair<lookaheads_t, bool> compute_first_of_rest(item_t const& item, first_sets_t const& first_sets, item_grammar_t const& items) const
+	{
+		lookaheads_t first_beta;
+		const auto& rhs = items.rule(item).rhs;
+		for (std::size_t i = item.dot() + 1; i < rhs.size(); ++i)
+		{
+			const auto& sym = rhs[i];
+			if (!first_sets.contains(sym))
+			{
+				first_beta.insert(sym);
+				return { std::move(first_beta), false };
+			}
+
+			const auto& sym_first = first_sets.at(sym);
+			for (const auto& a : sym_first)
+			{
+				if (a != m_epsilon)
+				{
+					first_beta.insert(a);
+				}
+			}
+
+			if (!sym_first.contains(m_epsilon))
+			{
+				return { std::move(first_beta), false };
+			}
+		}
+
+		return { std::move(first_beta), true };
+	}
+
+	std::map<item_t, marked_lookaheads> compute_marked_closure(
+		item_t const& kernel_item,
+		first_sets_t const& first_sets,
+		item_grammar_t const& items) const
+	{
+		std::map<item_t, marked_lookaheads> closure;
+		closure[kernel_item].propagated = true;
+
+		std::vector<item_t> pending{ kernel_item };
+		while (!pending.empty())
+		{
+			const item_t item = pending.back();
+			pending.pop_back();
+			if (!items.expands(item))
+			{
+				continue;
+			}
+
+			auto [first_beta, beta_has_epsilon] = compute_first_of_rest(item, first_sets, items);
+			if (beta_has_epsilon)
+			{
+				auto const& inherited = closure.at(item).symbols;
+				first_beta.insert(inherited.begin(), inherited.end());
+			}
+			const bool propagated = beta_has_epsilon && closure.at(item).propagated;
+
+			for (const item_t new_item : items.initial_items(items.next_symbol_id(item)))
+			{
+				auto [it, inserted] = closure.try_emplace(new_item);
+				auto& target = it->second;
+
+				const std::size_t old_size = target.symbols.size();
+				const bool old_propagated = target.propagated;
+				target.symbols.insert(first_beta.begin(), first_beta.end());
+				target.propagated = target.propagated || propagated;
+
+				if (inserted || target.symbols.size() != old_size || target.propagated != old_propagated)
+				{
+					pending.push_back(new_item);
+				}
+			}
+		}
+
+		return closure;
+	}
+
+	/**
+	 * LALR(1) lookaheads of every kernel item, by spontaneous generation and
+	 * propagation. `transitions` may be any automaton whose states are goto
+	 * targets of LR(0) cores, so it also refines a split LR(1) automaton.
+	 */
+	std::vector<std::vector<lookaheads_t>> compute_lookaheads(
+		std::vector<kernel_t> const& kernels,
+		transitions_t const& transitions,
+		first_sets_t const& first_sets,
+		item_grammar_t const& items) const
+	{
+		std::vector<std::vector<lookaheads_t>> lookaheads(kernels.size());
+		std::vector<std::vector<std::vector<detail::propagation_edge>>> edges(kernels.size());
+		for (std::size_t state = 0; state < kernels.size(); ++state)
+		{
+			lookaheads[state].resize(kernels[state].size());
+			edges[state].resize(kernels[state].size());
+		}
+
+		for (std::size_t state = 0; state < kernels.size(); ++state)
+		{
+			for (std::size_t k = 0; k < kernels[state].size(); ++k)
+			{
+				for (const auto& [item, marked] : compute_marked_closure(kernels[state][k], first_sets, items))
+				{
+					if (items.is_complete(item) || items.is_epsilon(items.next_symbol_id(item)))
+					{
+						continue;
+					}
+
+					const item_t next_item = item.advanced();
+					const std::size_t target = transitions.at({ state, items.next_symbol(item) });
+					const auto& target_kernel = kernels[target];
+					const auto target_index = static_cast<std::size_t>(std::lower_bound(target_kernel.begin(), target_kernel.end(), next_item) - target_kernel.begin());
+
+					lookaheads[target][target_index].insert(marked.symbols.begin(), marked.symbols.end());
+					if (marked.propagated)
+					{
+						edges[state][k].push_back({ target, target_index });
+					}
+				}
+			}
+		}
+
+		lookaheads[0][0].insert(m_eof);
+
+		std::vector<std::pair<std::size_t, std::size_t>> pending;
+		for (std::size_t state = 0; state < kernels.size(); ++state)
+		{
+			for (std::size_t k = 0; k < kernels[state].size(); ++k)
+			{
+				if (!lookaheads[state][k].empty())
+				{
+					pending.emplace_back(state, k);
+				}
+			}
+		}
+
+		while (!pending.empty())
+		{
+			const auto [state, k] = pending.back();
+			pending.pop_back();
+
+			for (const auto& edge : edges[state][k])
+			{
+				auto& target = lookaheads[edge.to_state][edge.to_item_index];
+				const std::size_t old_size = target.size();
+				target.insert(lookaheads[state][k].begin(), lookaheads[state][k].end());
+				if (target.size() != old_size)
+				{
+					pending.emplace_back(edge.to_state, edge.to_item_index);
+				}
+			}
+		}
+
+		return lookaheads;
+	}
+
+	/// Spreads lookaheads over the LR(0) closure of `I` until no item gains more.
+	lr1_state_t compute_closure(lr1_state_t I, first_sets_t const& first_sets, item_grammar_t const& items) const
+	{
+		std::vector<item_t> kernel;
+		kernel.reserve(I.size());
+		for (const auto& [item, _] : I)
+		{
+			kernel.push_back(item);
+		}
+
+		const auto closure = items.closure(kernel);
+		const auto index_of = [&closure](const item_t item) {
+			return static_cast<std::size_t>(std::lower_bound(closure.begin(), closure.end(), item) - closure.begin());
+		};
+
+		std::vector<lookaheads_t> lookaheads(closure.size());
+		for (auto& [item, item_lookaheads] : I)
+		{
+			lookaheads[index_of(item)] = std::move(item_lookaheads);
+		}
+
+		std::vector<std::pair<lookaheads_t, bool>> first_of_rest(closure.size());
+		std::vector<std::size_t> pending;
+		for (std::size_t i = 0; i < closure.size(); ++i)
+		{
+			if (items.expands(closure[i]))
+			{
+				first_of_rest[i] = compute_first_of_rest(closure[i], first_sets, items);
+				pending.push_back(i);
+			}
+		}
+
+		while (!pending.empty())
+		{
+			const std::size_t i = pending.back();
+			pending.pop_back();
+
+			const auto& [first_beta, beta_has_epsilon] = first_of_rest[i];
+			for (const item_t new_item : items.initial_items(items.next_symbol_id(closure[i])))
+			{
+				const std::size_t target = index_of(new_item);
+				auto& target_la = lookaheads[target];
+				const std::size_t old_size = target_la.size();
+
+				target_la.insert(first_beta.begin(), first_beta.end());
+				if (beta_has_epsilon && target != i)
+				{
+					target_la.insert(lookaheads[i].begin(), lookaheads[i].end());
+				}
+
+				if (target_la.size() != old_size && items.expands(new_item))
+				{
+					pending.push_back(target);
+				}
+			}
+		}
+
+		lr1_state_t result;
+		for (std::size_t i = 0; i < closure.size(); ++i)
+		{
+			result.emplace_hint(result.end(), closure[i], std::move(lookaheads[i]));
+		}
+
+		return result;
+	}
+
+	/// Adds the shift, goto, accept and reduce actions of closed LR(1) states.
+	template <typename T_CollisionPolicy>
+	void add_lr1_actions(
+		table_type& result,
+		std::vector<lr1_state_t> const& states,
+		transitions_t const& transitions,
+		item_grammar_t const& items,
+		T_CollisionPolicy policy,
+		std::vector<conflict_error<T_Symbol>>& errors) const
+	{
+		for (std::size_t i = 0; i < states.size(); ++i)
+		{
+			for (const auto& [item, lookaheads] : states[i])
+			{
+				if (!items.is_complete(item))
+				{ // SHIFT or GOTO
+					const auto a = items.next_symbol_id(item);
+					if (items.is_terminal(a) && transitions.contains({ i, items.symbol(a) }))
+					{
+						try_add_action(result, i, items.symbol(a), action_shift<std::size_t>{ transitions.at({ i, items.symbol(a) }) }, policy, errors);
+					}
+					else if (items.is_non_terminal(a) && transitions.contains({ i, items.symbol(a) }))
+					{
+						result.add_goto(i, items.symbol(a), transitions.at({ i, items.symbol(a) }));
+					}
+				}
+				else if (items.rule(item).lhs == m_aug_start)
+				{ // ACCEPT
+					try_add_action(result, i, m_eof, action_accept{}, policy, errors);
+				}
+				else
+				{ // REDUCE
+					for (const auto& a : lookaheads)
+					{
+						try_add_action(result, i, a, result.make_reduce(items.rule(item), m_epsilon), policy, errors);
+					}
+				}
+			}
+		}
+	}
+
 private:
 	T_Derived& derived_this()
 	{
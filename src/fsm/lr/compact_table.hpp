@@ -0,0 +1,420 @@
+#ifndef FSM_LR_COMPACT_TABLE_HPP
+#define FSM_LR_COMPACT_TABLE_HPP
+
+#include "../utility.hpp"
+#include "table.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace fsm::lr
+{
+namespace detail
+{
+/**
+ * @brief A sparse 2-D array packed by row displacement ("comb" compression).
+ *
+ * Each row is slid to the first offset where its cells land on free slots of
+ * one shared array; `check` remembers which row owns a slot. Rows are placed
+ * densest first, as yacc and bison do.
+ */
+template <typename T_Value>
+class comb_array
+{
+public:
+	using cell = std::pair<std::uint32_t, T_Value>;
+
+	static constexpr std::uint32_t no_row = static_cast<std::uint32_t>(-1);
+
+	comb_array() = default;
+
+	explicit comb_array(std::vector<std::vector<cell>> const& rows)
+		: m_base(rows.size(), 0)
+	{
+		std::vector<std::size_t> order(rows.size());
+		for (std::size_t i = 0; i < order.size(); ++i)
+		{
+			order[i] = i;
+		}
+		std::ranges::stable_sort(order, std::greater{}, [&](const std::size_t row) { return rows[row].size(); });
+
+		std::vector<bool> used;
+		std::size_t first_free = 0;
+		for (const std::size_t row : order)
+		{
+			if (rows[row].empty())
+			{
+				continue;
+			}
+
+			// Cells are sorted by column, so no base below this one can put the first cell on a free slot.
+			while (first_free < used.size() && used[first_free])
+			{
+				++first_free;
+			}
+			const std::size_t first_column = rows[row].front().first;
+			std::size_t base = first_free > first_column ? first_free - first_column : 0;
+			while (!fits(rows[row], base, used))
+			{
+				++base;
+			}
+
+			m_base[row] = static_cast<std::uint32_t>(base);
+			for (auto const& [column, value] : rows[row])
+			{
+				const std::size_t slot = base + column;
+				if (slot >= m_check.size())
+				{
+					m_check.resize(slot + 1, no_row);
+					m_value.resize(slot + 1);
+					used.resize(slot + 1, false);
+				}
+
+				m_check[slot] = static_cast<std::uint32_t>(row);
+				m_value[slot] = value;
+				used[slot] = true;
+			}
+		}
+	}
+
+	[[nodiscard]] std::optional<T_Value> find(const std::size_t row, const std::size_t column) const
+	{
+		if (row >= m_base.size())
+		{
+			return std::nullopt;
+		}
+
+		const std::size_t slot = m_base[row] + column;
+		if (slot < m_check.size() && m_check[slot] == row)
+		{
+			return m_value[slot];
+		}
+
+		return std::nullopt;
+	}
+
+	/// Number of slots of the packed array.
+	[[nodiscard]] std::size_t packed_size() const
+	{
+		return m_check.size();
+	}
+
+private:
+	std::vector<std::uint32_t> m_base;
+	std::vector<std::uint32_t> m_check;
+	std::vector<T_Value> m_value;
+
+	static bool fits(std::vector<cell> const& row, const std::size_t base, std::vector<bool> const& used)
+	{
+		return std::ranges::none_of(row, [&](cell const& c) {
+			const std::size_t slot = base + c.first;
+			return slot < used.size() && used[slot];
+		});
+	}
+};
+} // namespace detail
+
+/// A terminal's position in `compact_table::terminals()`, found once with `terminal_index`.
+struct terminal_column
+{
+	std::size_t index{};
+};
+
+/**
+ * @brief A frozen form of `lr::table` for parsing.
+ *
+ * Terminals are interned into a sorted array, non-terminals keep the goto
+ * columns of the source table, every distinct action is stored once, and the
+ * action and goto tables become comb-packed arrays of small indices. Lookups
+ * are a binary search of the symbol and an array access instead of two
+ * `std::map` searches. It is read through the same interface as `lr::table`,
+ * so `lr::parser` accepts either; `lr::parser` also looks up each input
+ * token's `terminal_column` once and reads its actions by column.
+ */
+template <typename T_Symbol, typename T_Compare = std::less<T_Symbol>>
+class compact_table
+{
+	using source_table_t = table<T_Symbol, T_Compare>;
+	using index_t = std::uint32_t;
+
+public:
+	using action_type = typename source_table_t::action_type;
+	using symbol_type = T_Symbol;
+	using compare_type = T_Compare;
+	using state_type = typename source_table_t::state_type;
+	using optional_state = std::optional<state_type>;
+	using rule_type = typename source_table_t::rule_type;
+
+	compact_table() = default;
+
+	explicit compact_table(source_table_t const& tbl)
+		: m_rules{ tbl.rules() }
+		, m_non_terminals{ tbl.non_terminals() }
+		, m_eof{ tbl.end_marker() }
+	{
+		std::size_t state_count = 0;
+		for (auto const& [state, row] : tbl.action_table())
+		{
+			state_count = std::max(state_count, state + 1);
+			for (auto const& [terminal, _] : row)
+			{
+				m_terminals.push_back(terminal);
+			}
+		}
+		for (auto const& [state, _] : tbl.goto_table())
+		{
+			state_count = std::max(state_count, state + 1);
+		}
+		intern(m_terminals);
+
+		const T_Compare less{};
+		m_non_terminal_order.resize(m_non_terminals.size());
+		for (std::size_t i = 0; i < m_non_terminal_order.size(); ++i)
+		{
+			m_non_terminal_order[i] = static_cast<index_t>(i);
+		}
+		std::ranges::sort(m_non_terminal_order, [&](const index_t a, const index_t b) {
+			return less(m_non_terminals[a], m_non_terminals[b]);
+		});
+
+		m_actions.emplace_back(action_error{});
+		std::map<state_type, index_t> shift_ids;
+		std::vector<index_t> reduce_ids(m_rules.size(), 0);
+		std::optional<index_t> accept_id;
+
+		const auto action_id = [&](action_type const& act) -> index_t {
+			const auto next_id = static_cast<index_t>(m_actions.size());
+			index_t id = next_id;
+			utility::overloaded_visitor(
+				act,
+				[&](const action_error&) { id = 0; },
+				[&](const action_accept&) {
+					id = accept_id.value_or(next_id);
+					accept_id = id;
+				},
+				[&](const action_shift<state_type>& s) { id = shift_ids.try_emplace(s.target_state, next_id).first->second; },
+				[&](const action_reduce& r) {
+					id = reduce_ids[r.rule_index] != 0 ? reduce_ids[r.rule_index] : next_id;
+					reduce_ids[r.rule_index] = id;
+				});
+			if (id == next_id)
+			{
+				m_actions.push_back(act);
+			}
+
+			return id;
+		};
+
+		std::vector<std::vector<typename detail::comb_array<index_t>::cell>> action_rows(state_count);
+		for (auto const& [state, row] : tbl.action_table())
+		{
+			for (auto const& [terminal, act] : row)
+			{
+				if (const index_t id = action_id(act); id != 0)
+				{
+					action_rows[state].emplace_back(terminal_index(terminal)->index, id);
+				}
+			}
+		}
+
+		std::vector<std::vector<typename detail::comb_array<state_type>::cell>> goto_rows(state_count);
+		for (auto const& [state, row] : tbl.goto_table())
+		{
+			for (auto const& [non_terminal, target] : row)
+			{
+				goto_rows[state].emplace_back(*non_terminal_index(non_terminal), target);
+			}
+			std::ranges::sort(goto_rows[state], {}, &detail::comb_array<state_type>::cell::first);
+		}
+
+		for (auto const& [state, row] : tbl.conflict_table())
+		{
+			for (auto const& [terminal, alternatives] : row)
+			{
+				m_conflicts.emplace(std::pair{ state, terminal_index(terminal)->index }, alternatives);
+			}
+		}
+
+		m_action_comb = detail::comb_array<index_t>(action_rows);
+		m_goto_comb = detail::comb_array<state_type>(goto_rows);
+		m_state_count = state_count;
+	}
+
+	const action_type& get_action(const state_type state, const T_Symbol& terminal) const
+	{
+		if (const auto column = terminal_index(terminal))
+		{
+			return get_action(state, *column);
+		}
+
+		return m_actions.front();
+	}
+
+	const action_type& get_action(const state_type state, const terminal_column column) const
+	{
+		return m_actions[m_action_comb.find(state, column.index).value_or(0)];
+	}
+
+	const action_type& get_action(const optional_state state, const T_Symbol& terminal) const
+	{
+		if (!state.has_value())
+		{
+			return m_actions.front();
+		}
+
+		return get_action(*state, terminal);
+	}
+
+	/// Actions the source table kept besides `get_action(state, terminal)`.
+	std::span<const action_type> conflicting_actions(const state_type state, const T_Symbol& terminal) const
+	{
+		if (m_conflicts.empty())
+		{
+			return {};
+		}
+
+		if (const auto column = terminal_index(terminal))
+		{
+			if (const auto it = m_conflicts.find({ state, column->index }); it != m_conflicts.end())
+			{
+				return it->second;
+			}
+		}
+
+		return {};
+	}
+
+	optional_state get_goto(const state_type state, const T_Symbol& non_terminal) const
+	{
+		if (const auto column = non_terminal_index(non_terminal))
+		{
+			return m_goto_comb.find(state, *column);
+		}
+
+		return std::nullopt;
+	}
+
+	/// The state entered after `reduce` uncovers `state`.
+	optional_state get_goto(const state_type state, const action_reduce& reduce) const
+	{
+		return m_goto_comb.find(state, reduce.lhs_column);
+	}
+
+	const rule_type& rule(const std::size_t rule_index) const
+	{
+		return m_rules[rule_index];
+	}
+
+	const std::vector<rule_type>& rules() const
+	{
+		return m_rules;
+	}
+
+	/// Terminals with a non-error action in `state`, in `T_Compare` order.
+	[[nodiscard]] std::vector<T_Symbol> expected_terminals(const state_type state) const
+	{
+		std::vector<T_Symbol> expected;
+		for (std::size_t column = 0; column < m_terminals.size(); ++column)
+		{
+			if (m_action_comb.find(state, column))
+			{
+				expected.push_back(m_terminals[column]);
+			}
+		}
+
+		return expected;
+	}
+
+	const T_Symbol& end_marker() const
+	{
+		return m_eof;
+	}
+
+	[[nodiscard]] std::size_t state_count() const
+	{
+		return m_state_count;
+	}
+
+	[[nodiscard]] std::vector<T_Symbol> const& terminals() const
+	{
+		return m_terminals;
+	}
+
+	/// Non-terminals in goto column order, as in the source table.
+	[[nodiscard]] std::vector<T_Symbol> const& non_terminals() const
+	{
+		return m_non_terminals;
+	}
+
+	/// Distinct actions; index 0 is the error action.
+	[[nodiscard]] std::vector<action_type> const& actions() const
+	{
+		return m_actions;
+	}
+
+	/// Column of `terminal`, or nothing if no state has an action on it.
+	[[nodiscard]] std::optional<terminal_column> terminal_index(T_Symbol const& terminal) const
+	{
+		const T_Compare less{};
+		const auto it = std::ranges::lower_bound(m_terminals, terminal, less);
+		if (it == m_terminals.end() || less(terminal, *it))
+		{
+			return std::nullopt;
+		}
+
+		return terminal_column{ static_cast<std::size_t>(it - m_terminals.begin()) };
+	}
+
+	/// Slots of the packed action and goto arrays together.
+	[[nodiscard]] std::size_t packed_size() const
+	{
+		return m_action_comb.packed_size() + m_goto_comb.packed_size();
+	}
+
+private:
+	std::vector<T_Symbol> m_terminals;
+	std::vector<rule_type> m_rules;
+	std::vector<T_Symbol> m_non_terminals;
+	std::vector<index_t> m_non_terminal_order;
+	std::vector<action_type> m_actions;
+	std::map<std::pair<state_type, std::size_t>, std::vector<action_type>> m_conflicts;
+
+	detail::comb_array<index_t> m_action_comb;
+	detail::comb_array<state_type> m_goto_comb;
+
+	std::size_t m_state_count = 0;
+	T_Symbol m_eof;
+
+	static void intern(std::vector<T_Symbol>& symbols)
+	{
+		const T_Compare less{};
+		std::ranges::sort(symbols, less);
+		const auto [first, last] = std::ranges::unique(symbols, [&](T_Symbol const& a, T_Symbol const& b) {
+			return !less(a, b) && !less(b, a);
+		});
+		symbols.erase(first, last);
+	}
+
+	std::optional<std::size_t> non_terminal_index(T_Symbol const& non_terminal) const
+	{
+		const T_Compare less{};
+		const auto column_of = [&](const index_t column) -> T_Symbol const& { return m_non_terminals[column]; };
+		const auto it = std::ranges::lower_bound(m_non_terminal_order, non_terminal, less, column_of);
+		if (it == m_non_terminal_order.end() || less(non_terminal, m_non_terminals[*it]))
+		{
+			return std::nullopt;
+		}
+
+		return *it;
+	}
+};
+
+template <typename T_Symbol, typename T_Compare>
+compact_table(table<T_Symbol, T_Compare> const&) -> compact_table<T_Symbol, T_Compare>;
+} // namespace fsm::lr
+
+#endif // FSM_LR_COMPACT_TABLE_HPP
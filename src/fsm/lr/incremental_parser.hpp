@@ -0,0 +1,324 @@
+#ifndef FSM_LR_INCREMENTAL_PARSER_HPP
+#define FSM_LR_INCREMENTAL_PARSER_HPP
+
+#include "parser.hpp"
+
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace fsm::lr
+{
+/**
+ * @brief An immutable node of a tree built by `lr::incremental_parser`.
+ *
+ * A node stores how many tokens it covers rather than where they are, so an
+ * edit elsewhere leaves it valid and later trees can share it. `left_state` is
+ * the parser state below the node when it was pushed.
+ */
+struct syntax_node
+{
+	static constexpr std::uint32_t no_rule = static_cast<std::uint32_t>(-1);
+
+	std::uint32_t rule_index = no_rule;
+	std::size_t left_state{};
+	std::size_t token_count{};
+	std::vector<std::shared_ptr<const syntax_node>> children;
+
+	[[nodiscard]] bool is_token() const
+	{
+		return rule_index == no_rule;
+	}
+};
+
+using syntax_tree = std::shared_ptr<const syntax_node>;
+
+/// Tokens `[offset, offset + removed)` of the previous input replaced by `inserted` new ones.
+struct token_edit
+{
+	std::size_t offset{};
+	std::size_t removed{};
+	std::size_t inserted{};
+};
+
+/// What the last parse took over from the previous tree.
+struct reparse_stats
+{
+	std::size_t reused_subtrees{}; // non-terminal subtrees shifted whole
+	std::size_t reused_tokens{}; // tokens under those subtrees, plus token leaves shifted again
+};
+
+/**
+ * @brief Builds a `syntax_tree` and rebuilds it after an edit.
+ *
+ * A reparse reads the previous tree as its input, left to right. A subtree
+ * outside the edit is shifted whole when the parser reaches it in the state it
+ * was built in and the token after it is unchanged, since LR actions would
+ * rebuild it exactly (Wagner and Graham, "Efficient and Flexible Incremental
+ * Parsing", 1998). Other subtrees are split into their children, and the edit
+ * itself is parsed token by token.
+ */
+template <
+	typename T_Symbol,
+	typename T_Compare = std::less<T_Symbol>,
+	typename T_Table = table<T_Symbol, T_Compare>>
+class incremental_parser
+{
+public:
+	using table_type = T_Table;
+	using symbol_type = T_Symbol;
+	using state_type = typename table_type::state_type;
+	using error_type = event_error<T_Symbol>;
+
+	explicit incremental_parser(const table_type& tbl)
+		: m_table{ tbl }
+	{
+	}
+
+	std::expected<syntax_tree, error_type> parse(std::span<const T_Symbol> input)
+	{
+		return run(nullptr, input, { .offset = 0, .removed = 0, .inserted = input.size() });
+	}
+
+	/// Parses `input`, which is the input of `previous` changed by `edit`.
+	std::expected<syntax_tree, error_type> reparse(
+		const syntax_tree& previous,
+		std::span<const T_Symbol> input,
+		const token_edit& edit)
+	{
+		if (previous == nullptr
+			|| edit.offset + edit.removed > previous->token_count
+			|| input.size() != previous->token_count - edit.removed + edit.inserted)
+		{
+			throw std::invalid_argument("Edit does not match the previous tree and input");
+		}
+
+		return run(previous, input, edit);
+	}
+
+	[[nodiscard]] const reparse_stats& stats() const
+	{
+		return m_stats;
+	}
+
+private:
+	/// A subtree of the previous tree that starts at token `start` of the previous input.
+	struct pending_subtree
+	{
+		syntax_tree node;
+		std::size_t start;
+	};
+
+	struct stack_entry
+	{
+		state_type state;
+		syntax_tree node;
+	};
+
+	const table_type& m_table;
+	std::span<const T_Symbol> m_input;
+	token_edit m_edit;
+	std::size_t m_position = 0;
+
+	std::vector<pending_subtree> m_pending;
+	std::vector<stack_entry> m_stack;
+	reparse_stats m_stats;
+
+	std::expected<syntax_tree, error_type> run(const syntax_tree& previous, std::span<const T_Symbol> input, const token_edit& edit)
+	{
+		m_input = input;
+		m_edit = edit;
+		m_position = 0;
+		m_stats = {};
+		m_pending.clear();
+		m_stack.clear();
+
+		m_stack.push_back({ 0, nullptr });
+		if (previous != nullptr)
+		{
+			m_pending.push_back({ previous, 0 });
+		}
+
+		while (true)
+		{
+			const pending_subtree* next = next_subtree();
+			if (next != nullptr && !next->node->is_token() && new_start(next->start) == m_position)
+			{
+				shift_or_split(*next);
+				continue;
+			}
+
+			const T_Symbol& token = m_position < m_input.size() ? m_input[m_position] : m_table.end_marker();
+			const auto& act = m_table.get_action(m_stack.back().state, token);
+			if (actions::is_shift(act))
+			{
+				syntax_tree leaf;
+				if (next != nullptr && new_start(next->start) == m_position)
+				{
+					if (next->node->left_state == m_stack.back().state)
+					{
+						leaf = next->node;
+						++m_stats.reused_tokens;
+					}
+					m_pending.pop_back();
+				}
+				if (leaf == nullptr)
+				{
+					leaf = std::make_shared<const syntax_node>(syntax_node{
+						.rule_index = syntax_node::no_rule,
+						.left_state = m_stack.back().state,
+						.token_count = 1,
+						.children = {},
+					});
+				}
+
+				m_stack.push_back({ actions::as_shift(act).target_state, std::move(leaf) });
+				++m_position;
+			}
+			else if (actions::is_reduce(act))
+			{
+				if (!reduce(actions::as_reduce(act)))
+				{
+					return std::unexpected(error_type{ token, m_table.expected_terminals(m_stack.back().state) });
+				}
+			}
+			else if (actions::is_accept(act))
+			{
+				return m_stack.back().node;
+			}
+			else
+			{
+				return std::unexpected(error_type{ token, m_table.expected_terminals(m_stack.back().state) });
+			}
+		}
+	}
+
+	std::size_t new_start(const std::size_t old_start) const
+	{
+		return old_start < m_edit.offset ? old_start : old_start - m_edit.removed + m_edit.inserted;
+	}
+
+	/// Neither the subtree nor the token after it was touched by the edit.
+	bool reusable(const pending_subtree& subtree) const
+	{
+		const std::size_t end = subtree.start + subtree.node->token_count;
+
+		return end < m_edit.offset || subtree.start >= m_edit.offset + m_edit.removed;
+	}
+
+	/// The next subtree of the previous tree that can still be used, splitting damaged ones.
+	const pending_subtree* next_subtree()
+	{
+		while (!m_pending.empty())
+		{
+			const pending_subtree top = m_pending.back();
+			if (top.node->token_count == 0)
+			{
+				// ε-subtrees cost nothing to rebuild and have no token to check the state against.
+				m_pending.pop_back();
+			}
+			else if (top.node->is_token())
+			{
+				if (top.start < m_edit.offset || top.start >= m_edit.offset + m_edit.removed)
+				{
+					return &m_pending.back();
+				}
+				m_pending.pop_back();
+			}
+			else if (!reusable(top))
+			{
+				split(top);
+			}
+			else
+			{
+				return &m_pending.back();
+			}
+		}
+
+		return nullptr;
+	}
+
+	void split(const pending_subtree subtree)
+	{
+		m_pending.pop_back();
+
+		std::size_t end = subtree.start + subtree.node->token_count;
+		for (auto it = subtree.node->children.rbegin(); it != subtree.node->children.rend(); ++it)
+		{
+			end -= (*it)->token_count;
+			m_pending.push_back({ *it, end });
+		}
+	}
+
+	/// Reduces on the subtree's first token, then shifts it whole if the parser is in its state.
+	void shift_or_split(const pending_subtree subtree)
+	{
+		const T_Symbol& first_token = m_input[m_position];
+		while (true)
+		{
+			const auto& act = m_table.get_action(m_stack.back().state, first_token);
+			if (!actions::is_reduce(act) || !reduce(actions::as_reduce(act)))
+			{
+				break;
+			}
+		}
+
+		const state_type state = m_stack.back().state;
+		const auto target = subtree.node->left_state == state
+			? m_table.get_goto(state, m_table.rule(subtree.node->rule_index).lhs)
+			: std::nullopt;
+		if (!target)
+		{
+			split(subtree);
+			return;
+		}
+
+		m_pending.pop_back();
+		m_stack.push_back({ *target, subtree.node });
+		m_position += subtree.node->token_count;
+
+		++m_stats.reused_subtrees;
+		m_stats.reused_tokens += subtree.node->token_count;
+	}
+
+	bool reduce(const action_reduce& reduce)
+	{
+		const auto first = m_stack.end() - reduce.pop_count;
+		const state_type left_state = (first - 1)->state;
+		const auto target = m_table.get_goto(left_state, reduce);
+		if (!target)
+		{
+			return false;
+		}
+
+		syntax_node node{
+			.rule_index = reduce.rule_index,
+			.left_state = left_state,
+			.token_count = 0,
+			.children = {},
+		};
+		node.children.reserve(reduce.pop_count);
+		for (auto it = first; it != m_stack.end(); ++it)
+		{
+			node.token_count += it->node->token_count;
+			node.children.push_back(std::move(it->node));
+		}
+		m_stack.erase(first, m_stack.end());
+
+		m_stack.push_back({ *target, std::make_shared<const syntax_node>(std::move(node)) });
+
+		return true;
+	}
+};
+
+template <typename T_Symbol, typename T_Compare>
+incremental_parser(const table<T_Symbol, T_Compare>&) -> incremental_parser<T_Symbol, T_Compare, table<T_Symbol, T_Compare>>;
+
+template <typename T_Symbol, typename T_Compare>
+incremental_parser(const compact_table<T_Symbol, T_Compare>&) -> incremental_parser<T_Symbol, T_Compare, compact_table<T_Symbol, T_Compare>>;
+} // namespace fsm::lr
+
+#endif // FSM_LR_INCREMENTAL_PARSER_HPP
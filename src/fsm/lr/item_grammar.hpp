@@ -0,0 +1,217 @@
+#ifndef FSM_LR_ITEM_GRAMMAR_HPP
+#define FSM_LR_ITEM_GRAMMAR_HPP
+
+#include "../cfg/basic_cfg.hpp"
+#include "lr0_item.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace fsm::lr::detail
+{
+/**
+ * @brief The rules of an augmented grammar, numbered for `lr0_item`.
+ *
+ * Rules are numbered in `cfg_rule` order and symbols in `T_Compare` order, so
+ * sorting items or goto symbols by id gives the order builders number states
+ * in. The LR(0) closure of every non-terminal is computed once, and closing a
+ * kernel merges the lists of the symbols after its dots.
+ */
+template <typename T_Symbol, typename T_Compare>
+class item_grammar
+{
+public:
+	using symbol_id = std::uint32_t;
+
+	item_grammar(basic_cfg<T_Symbol, T_Compare> const& grammar, T_Symbol const& epsilon, T_Symbol const& aug_start)
+		: m_rules(grammar.rules().begin(), grammar.rules().end())
+	{
+		const cfg_rule<T_Symbol> aug_rule{ aug_start, { grammar.start_symbol() } };
+		auto aug_it = std::lower_bound(m_rules.begin(), m_rules.end(), aug_rule);
+		const bool aug_in_grammar = aug_it != m_rules.end() && *aug_it == aug_rule;
+		if (!aug_in_grammar)
+		{
+			aug_it = m_rules.insert(aug_it, aug_rule);
+		}
+		const auto aug_index = static_cast<std::uint32_t>(aug_it - m_rules.begin());
+		m_start_item = lr0_item{ aug_index, 0 };
+
+		for (const auto& rule : m_rules)
+		{
+			m_symbols.push_back(rule.lhs);
+			m_symbols.insert(m_symbols.end(), rule.rhs.begin(), rule.rhs.end());
+		}
+		m_symbols.push_back(epsilon);
+		std::ranges::sort(m_symbols, T_Compare{});
+		const auto duplicates = std::ranges::unique(m_symbols, [](T_Symbol const& a, T_Symbol const& b) {
+			return !T_Compare{}(a, b) && !T_Compare{}(b, a);
+		});
+		m_symbols.erase(duplicates.begin(), duplicates.end());
+
+		m_epsilon = id_of(epsilon);
+		m_terminal.resize(m_symbols.size());
+		m_non_terminal.resize(m_symbols.size());
+		for (symbol_id id = 0; id < m_symbols.size(); ++id)
+		{
+			m_terminal[id] = grammar.is_terminal(m_symbols[id]);
+			m_non_terminal[id] = grammar.is_non_terminal(m_symbols[id]);
+		}
+
+		m_initial_items.resize(m_symbols.size());
+		m_rhs.reserve(m_rules.size());
+		for (std::uint32_t index = 0; index < m_rules.size(); ++index)
+		{
+			const auto& rule = m_rules[index];
+			auto& rhs = m_rhs.emplace_back();
+			for (const auto& symbol : rule.rhs)
+			{
+				rhs.push_back(id_of(symbol));
+			}
+
+			if (index != aug_index || aug_in_grammar)
+			{
+				const std::uint32_t initial_dot = (rhs.size() == 1 && rhs[0] == m_epsilon) ? 1 : 0;
+				m_initial_items[id_of(rule.lhs)].push_back(lr0_item{ index, initial_dot });
+			}
+		}
+
+		m_closures.resize(m_symbols.size());
+		for (symbol_id id = 0; id < m_symbols.size(); ++id)
+		{
+			if (!m_terminal[id])
+			{
+				m_closures[id] = close_symbol(id);
+			}
+		}
+	}
+
+	[[nodiscard]] lr0_item start_item() const
+	{
+		return m_start_item;
+	}
+
+	[[nodiscard]] cfg_rule<T_Symbol> const& rule(const lr0_item item) const
+	{
+		return m_rules[item.rule_index()];
+	}
+
+	[[nodiscard]] bool is_complete(const lr0_item item) const
+	{
+		return item.dot() >= m_rhs[item.rule_index()].size();
+	}
+
+	[[nodiscard]] symbol_id next_symbol_id(const lr0_item item) const
+	{
+		return m_rhs[item.rule_index()][item.dot()];
+	}
+
+	[[nodiscard]] T_Symbol const& next_symbol(const lr0_item item) const
+	{
+		return m_symbols[next_symbol_id(item)];
+	}
+
+	[[nodiscard]] T_Symbol const& symbol(const symbol_id id) const
+	{
+		return m_symbols[id];
+	}
+
+	[[nodiscard]] bool is_terminal(const symbol_id id) const
+	{
+		return m_terminal[id];
+	}
+
+	[[nodiscard]] bool is_non_terminal(const symbol_id id) const
+	{
+		return m_non_terminal[id];
+	}
+
+	[[nodiscard]] bool is_epsilon(const symbol_id id) const
+	{
+		return id == m_epsilon;
+	}
+
+	/// The item is not complete and its next symbol is not a terminal.
+	[[nodiscard]] bool expands(const lr0_item item) const
+	{
+		return !is_complete(item) && !m_terminal[next_symbol_id(item)];
+	}
+
+	/// The items of the rules of `lhs` with the dot at the start, past ε for ε-rules.
+	[[nodiscard]] std::span<const lr0_item> initial_items(const symbol_id lhs) const
+	{
+		return m_initial_items[lhs];
+	}
+
+	/// The sorted LR(0) closure of `kernel`.
+	template <typename T_Items>
+	[[nodiscard]] std::vector<lr0_item> closure(T_Items const& kernel) const
+	{
+		std::vector<lr0_item> result(kernel.begin(), kernel.end());
+		std::vector<symbol_id> expanded;
+		for (const lr0_item item : kernel)
+		{
+			if (expands(item))
+			{
+				expanded.push_back(next_symbol_id(item));
+			}
+		}
+		std::ranges::sort(expanded);
+		expanded.erase(std::ranges::unique(expanded).begin(), expanded.end());
+
+		for (const symbol_id id : expanded)
+		{
+			result.insert(result.end(), m_closures[id].begin(), m_closures[id].end());
+		}
+		std::ranges::sort(result);
+		result.erase(std::ranges::unique(result).begin(), result.end());
+
+		return result;
+	}
+
+private:
+	std::vector<cfg_rule<T_Symbol>> m_rules;
+	std::vector<std::vector<symbol_id>> m_rhs;
+	std::vector<T_Symbol> m_symbols;
+	std::vector<bool> m_terminal;
+	std::vector<bool> m_non_terminal;
+	symbol_id m_epsilon{};
+	lr0_item m_start_item;
+
+	std::vector<std::vector<lr0_item>> m_initial_items;
+	std::vector<std::vector<lr0_item>> m_closures;
+
+	symbol_id id_of(T_Symbol const& symbol) const
+	{
+		return static_cast<symbol_id>(std::ranges::lower_bound(m_symbols, symbol, T_Compare{}) - m_symbols.begin());
+	}
+
+	std::vector<lr0_item> close_symbol(const symbol_id lhs) const
+	{
+		std::vector<lr0_item> result;
+		std::vector<bool> visited(m_symbols.size());
+		std::vector<symbol_id> pending{ lhs };
+		visited[lhs] = true;
+		while (!pending.empty())
+		{
+			const symbol_id current = pending.back();
+			pending.pop_back();
+			for (const lr0_item item : m_initial_items[current])
+			{
+				result.push_back(item);
+				if (expands(item) && !visited[next_symbol_id(item)])
+				{
+					visited[next_symbol_id(item)] = true;
+					pending.push_back(next_symbol_id(item));
+				}
+			}
+		}
+		std::ranges::sort(result);
+
+		return result;
+	}
+};
+} // namespace fsm::lr::detail
+
+#endif // FSM_LR_ITEM_GRAMMAR_HPP
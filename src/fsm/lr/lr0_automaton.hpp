@@ -0,0 +1,177 @@
+#ifndef FSM_LR_LR0_AUTOMATON_HPP
+#define FSM_LR_LR0_AUTOMATON_HPP
+
+#include "item_grammar.hpp"
+#include "lr0_item.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace fsm::lr::detail
+{
+template <typename T_Symbol>
+struct lr0_automaton
+{
+	std::vector<item_kernel> kernels;
+	std::map<std::pair<std::size_t, T_Symbol>, std::size_t> transitions;
+};
+
+/**
+ * @brief Kernel to state id map that several threads can fill at once.
+ *
+ * Kernels are spread over mutex-guarded shards by their hash. A kernel is added
+ * with an `unnumbered` id, which its owner sets later; entries never move.
+ */
+class concurrent_kernel_map
+{
+public:
+	static constexpr std::size_t unnumbered = static_cast<std::size_t>(-1);
+
+	struct entry
+	{
+		item_kernel const* kernel;
+		std::size_t* id;
+	};
+
+	entry find_or_add(item_kernel kernel)
+	{
+		auto& shard = m_shards[kernel.hash() % shard_count];
+
+		std::scoped_lock lock(shard.mutex);
+		auto [it, inserted] = shard.ids.try_emplace(std::move(kernel), unnumbered);
+
+		return { &it->first, &it->second };
+	}
+
+private:
+	static constexpr std::size_t shard_count = 64;
+
+	struct shard
+	{
+		std::mutex mutex;
+		std::unordered_map<item_kernel, std::size_t, item_kernel::hasher> ids;
+	};
+
+	std::array<shard, shard_count> m_shards;
+};
+
+/**
+ * @brief Builds the LR(0) automaton of `items`, one breadth-first level at a time.
+ *
+ * The states of a level are expanded on up to `thread_count` threads, and new
+ * kernels are deduplicated through a `concurrent_kernel_map`. Ids are then
+ * given in (source state, symbol) order, so states are numbered as a
+ * single-threaded breadth-first walk would number them, whatever the thread
+ * count.
+ */
+template <typename T_Symbol, typename T_Compare>
+lr0_automaton<T_Symbol> build_lr0_automaton(item_grammar<T_Symbol, T_Compare> const& items, const std::size_t thread_count)
+{
+	using symbol_id = typename item_grammar<T_Symbol, T_Compare>::symbol_id;
+
+	struct goto_target
+	{
+		symbol_id symbol;
+		concurrent_kernel_map::entry target;
+	};
+
+	lr0_automaton<T_Symbol> automaton;
+	concurrent_kernel_map kernel_ids;
+
+	item_kernel start_kernel({ items.start_item() });
+	*kernel_ids.find_or_add(start_kernel).id = 0;
+	automaton.kernels.push_back(std::move(start_kernel));
+
+	std::vector<std::vector<goto_target>> level_gotos;
+	for (std::size_t level_begin = 0; level_begin < automaton.kernels.size();)
+	{
+		const std::size_t level_end = automaton.kernels.size();
+		level_gotos.assign(level_end - level_begin, {});
+
+		std::atomic<std::size_t> next_state = level_begin;
+		std::exception_ptr error;
+		std::once_flag error_flag;
+
+		const auto expand_states = [&] {
+			for (std::size_t id = next_state++; id < level_end; id = next_state++)
+			{
+				try
+				{
+					// Symbol ids follow `T_Compare` and the closure is sorted, so sorting groups kernels in order.
+					std::vector<std::pair<symbol_id, lr0_item>> moves;
+					for (const lr0_item item : items.closure(automaton.kernels[id]))
+					{
+						if (!items.is_complete(item) && !items.is_epsilon(items.next_symbol_id(item)))
+						{
+							moves.emplace_back(items.next_symbol_id(item), item.advanced());
+						}
+					}
+					std::ranges::sort(moves);
+
+					auto& out = level_gotos[id - level_begin];
+					for (auto first = moves.begin(); first != moves.end();)
+					{
+						const auto last = std::find_if(first, moves.end(), [&](const auto& move) { return move.first != first->first; });
+
+						std::vector<lr0_item> kernel;
+						kernel.reserve(last - first);
+						std::transform(first, last, std::back_inserter(kernel), [](const auto& move) { return move.second; });
+						out.push_back({ first->first, kernel_ids.find_or_add(item_kernel(std::move(kernel))) });
+
+						first = last;
+					}
+				}
+				catch (...)
+				{
+					std::call_once(error_flag, [&] { error = std::current_exception(); });
+					next_state = level_end;
+				}
+			}
+		};
+
+		{
+			const std::size_t workers_count = std::min(std::max<std::size_t>(thread_count, 1), level_end - level_begin);
+			std::vector<std::jthread> workers;
+			for (std::size_t i = 1; i < workers_count; ++i)
+			{
+				workers.emplace_back(expand_states);
+			}
+			expand_states();
+		}
+
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+
+		for (std::size_t id = level_begin; id < level_end; ++id)
+		{
+			for (auto& [X, target] : level_gotos[id - level_begin])
+			{
+				if (*target.id == concurrent_kernel_map::unnumbered)
+				{
+					*target.id = automaton.kernels.size();
+					automaton.kernels.push_back(*target.kernel);
+				}
+
+				automaton.transitions[{ id, items.symbol(X) }] = *target.id;
+			}
+		}
+
+		level_begin = level_end;
+	}
+
+	return automaton;
+}
+} // namespace fsm::lr::detail
+
+#endif // FSM_LR_LR0_AUTOMATON_HPP
@@ -1,52 +1,119 @@
 #ifndef FSM_DETAIL_LR0_ITEM_HPP
 #define FSM_DETAIL_LR0_ITEM_HPP
 
-#include "../detail/cfg_rule.hpp"
+#include <compare>
+#include <cstdint>
+#include <functional>
+#include <vector>
 
 namespace fsm::lr
 {
-namespace detail
-{
-template <typename T_Symbol>
-struct basic_lr0_item
+/**
+ * @brief An LR(0) item as a rule index and a dot position packed into 64 bits.
+ *
+ * Items order by dot, then by rule index. `detail::item_grammar` numbers rules
+ * in `cfg_rule` order, so this is the order of items compared by their rules.
+ */
+class lr0_item
 {
-	cfg_rule<T_Symbol> rule;
-	std::size_t dot = 0;
+public:
+	constexpr lr0_item() = default;
+
+	constexpr lr0_item(const std::uint32_t rule_index, const std::uint32_t dot)
+		: m_value{ static_cast<std::uint64_t>(dot) << 32 | rule_index }
+	{
+	}
+
+	[[nodiscard]] constexpr std::uint32_t rule_index() const
+	{
+		return static_cast<std::uint32_t>(m_value);
+	}
+
+	[[nodiscard]] constexpr std::uint32_t dot() const
+	{
+		return static_cast<std::uint32_t>(m_value >> 32);
+	}
 
-	[[nodiscard]] bool is_complete() const
+	/// The item with the dot moved over the next symbol.
+	[[nodiscard]] constexpr lr0_item advanced() const
 	{
-		return dot >= rule.rhs.size();
+		return lr0_item{ rule_index(), dot() + 1 };
 	}
 
-	T_Symbol next_symbol() const
+	[[nodiscard]] constexpr std::uint64_t value() const
 	{
-		return rule.rhs[dot];
+		return m_value;
 	}
 
-	bool operator<(basic_lr0_item const& other) const
+	constexpr auto operator<=>(lr0_item const&) const = default;
+
+private:
+	std::uint64_t m_value = 0;
+};
+
+namespace detail
+{
+/// The sorted kernel items of an LR state, hashed once when built.
+class item_kernel
+{
+public:
+	struct hasher
 	{
-		if (dot != other.dot)
+		std::size_t operator()(item_kernel const& kernel) const
 		{
-			return dot < other.dot;
+			return kernel.hash();
 		}
-		if (rule.lhs != other.rule.lhs)
+	};
+
+	item_kernel() = default;
+
+	explicit item_kernel(std::vector<lr0_item> items)
+		: m_items(std::move(items))
+	{
+		std::size_t seed = m_items.size();
+		for (const auto& item : m_items)
 		{
-			return rule.lhs < other.rule.lhs;
+			seed ^= std::hash<std::uint64_t>{}(item.value()) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
 		}
+		m_hash = seed;
+	}
+
+	[[nodiscard]] std::size_t hash() const
+	{
+		return m_hash;
+	}
+
+	[[nodiscard]] std::size_t size() const
+	{
+		return m_items.size();
+	}
 
-		return rule.rhs < other.rule.rhs;
+	lr0_item const& operator[](const std::size_t index) const
+	{
+		return m_items[index];
 	}
 
-	bool operator==(basic_lr0_item const& other) const
+	auto begin() const
 	{
-		return dot == other.dot && rule.lhs == other.rule.lhs && rule.rhs == other.rule.rhs;
+		return m_items.begin();
 	}
+
+	auto end() const
+	{
+		return m_items.end();
+	}
+
+	bool operator==(item_kernel const& other) const
+	{
+		return m_hash == other.m_hash && m_items == other.m_items;
+	}
+
+private:
+	std::vector<lr0_item> m_items;
+	std::size_t m_hash = 0;
 };
 } // namespace detail
 
-template <typename T_Symbol>
-using lr0_item = detail::basic_lr0_item<T_Symbol>;
-
-} // namespace fsm
+} // namespace fsm::lr
 
 #endif // FSM_DETAIL_LR0_ITEM_HPP
@@ -2,8 +2,10 @@
 #define FSM_SLR_PARSER_HPP
 
 #include "../utility.hpp"
+#include "compact_table.hpp"
 #include "table.hpp"
 
+#include <cstdint>
 #include <span>
 #include <variant>
 
@@ -16,11 +18,11 @@ struct event_shift
 	T_Symbol token;
 };
 
-template <typename T_Symbol>
+/// Reduced by rule `rule_index` of the parser's table.
 struct event_reduce
 {
-	cfg_rule<T_Symbol> rule;
-	std::size_t pop_count;
+	std::uint32_t rule_index{};
+	std::uint32_t pop_count{};
 };
 
 struct event_accept
@@ -37,7 +39,7 @@ struct event_error
 template <typename T_Symbol>
 using parse_event = std::variant<
 	event_shift<T_Symbol>,
-	event_reduce<T_Symbol>,
+	event_reduce,
 	event_accept,
 	event_error<T_Symbol>>;
 
@@ -53,7 +55,7 @@ template <typename T_Symbol>
 bool is_shift(const parse_event<T_Symbol>& act) { return std::holds_alternative<event_shift<T_Symbol>>(act); }
 
 template <typename T_Symbol>
-bool is_reduce(const parse_event<T_Symbol>& act) { return std::holds_alternative<event_reduce<T_Symbol>>(act); }
+bool is_reduce(const parse_event<T_Symbol>& act) { return std::holds_alternative<event_reduce>(act); }
 
 template <typename T_Symbol>
 event_error<T_Symbol> as_error(const parse_event<T_Symbol>& act) { return std::get<event_error<T_Symbol>>(act); }
@@ -65,44 +67,80 @@ template <typename T_Symbol>
 event_shift<T_Symbol> as_shift(const parse_event<T_Symbol>& act) { return std::get<event_shift<T_Symbol>>(act); }
 
 template <typename T_Symbol>
-event_reduce<T_Symbol> as_reduce(const parse_event<T_Symbol>& act) { return std::get<event_reduce<T_Symbol>>(act); }
+event_reduce as_reduce(const parse_event<T_Symbol>& act) { return std::get<event_reduce>(act); }
 } // namespace events
 
-template <typename T_Symbol, typename T_Compare = std::less<T_Symbol>>
+enum class event_kind : std::uint8_t
+{
+	shift,
+	reduce,
+	accept,
+	error,
+};
+
+/**
+ * @brief A parse event that refers back to the parser's table and input.
+ *
+ * `token_index` is the shifted token, or the lookahead for the other kinds;
+ * it equals the input size at the end marker. `rule_index` and `pop_count`
+ * are set for reductions only.
+ */
+struct event_record
+{
+	event_kind kind{};
+	std::uint32_t rule_index{};
+	std::uint32_t pop_count{};
+	std::size_t token_index{};
+};
+
+/**
+ * `T_Table` is `lr::table` or `lr::compact_table`; both are read through
+ * `get_action`, `get_goto`, `expected_terminals`, `end_marker` and `rule`.
+ * With a `compact_table`, each input token is looked up once with
+ * `terminal_index` and its actions are then read by column.
+ *
+ * `parse` yields `parse_event`s; `records` walks the same steps but yields
+ * `event_record`s, which copy no symbols and never allocate.
+ */
+template <
+	typename T_Symbol,
+	typename T_Compare = std::less<T_Symbol>,
+	typename T_Table = table<T_Symbol, T_Compare>>
 class parser
 {
 	using event_t = parse_event<T_Symbol>;
 	using opt_event_t = std::optional<event_t>;
 
-	class iterator
+	template <typename T_Value>
+	class basic_iterator
 	{
 	public:
-		iterator() = default;
+		basic_iterator() = default;
 
-		explicit iterator(parser* ptr)
+		explicit basic_iterator(parser* ptr)
 			: m_ptr(ptr)
 		{
 			advance();
 		}
 
-		const event_t& operator*() const
+		const T_Value& operator*() const
 		{
 			return *m_current;
 		}
 
-		const event_t* operator->() const
+		const T_Value* operator->() const
 		{
-			return m_current;
+			return &*m_current;
 		}
 
-		iterator& operator++()
+		basic_iterator& operator++()
 		{
 			advance();
 
 			return *this;
 		}
 
-		bool operator!=(const iterator& rhs) const
+		bool operator!=(const basic_iterator& rhs) const
 		{
 			return m_ptr != rhs.m_ptr;
 		}
@@ -112,7 +150,15 @@ class parser
 		{
 			if (m_ptr)
 			{
-				m_current = m_ptr->next();
+				if constexpr (std::is_same_v<T_Value, event_record>)
+				{
+					m_current = m_ptr->next_record();
+				}
+				else
+				{
+					m_current = m_ptr->next();
+				}
+
 				if (!m_current)
 				{
 					m_ptr = nullptr;
@@ -121,42 +167,52 @@ class parser
 		}
 
 		parser* m_ptr = nullptr;
-		opt_event_t m_current = std::nullopt;
+		std::optional<T_Value> m_current = std::nullopt;
 	};
 
-	class iter_range
+	template <typename T_Value>
+	class basic_iter_range
 	{
 	public:
-		explicit iter_range(parser& p)
+		explicit basic_iter_range(parser& p)
 			: m_parser(p)
 		{
 		}
 
-		iterator begin() const
+		basic_iterator<T_Value> begin() const
 		{
-			return iterator{ &m_parser };
+			return basic_iterator<T_Value>{ &m_parser };
 		}
 
-		iterator end() const
+		basic_iterator<T_Value> end() const
 		{
-			return iterator{ nullptr };
+			return basic_iterator<T_Value>{ nullptr };
 		}
 
 	private:
 		parser& m_parser;
 	};
 
+	using iter_range = basic_iter_range<event_t>;
+	using record_range = basic_iter_range<event_record>;
+
 public:
-	using table_type = table<T_Symbol, T_Compare>;
+	using table_type = T_Table;
 	using state_type = table_type::state_type;
 	using event_type = event_t;
 	using optional_event_type = opt_event_t;
 
-	using iterator = iterator;
+	using iterator = basic_iterator<event_t>;
+	using record_iterator = basic_iterator<event_record>;
 
-	parser(const table_type& tbl, std::type_identity_t<T_Symbol> epsilon_symbol)
+	explicit parser(const table_type& tbl)
+		: m_table{ tbl }
+	{
+	}
+
+	/// ε-rules are already reduced with no pops by the table, so `epsilon_symbol` is unused.
+	parser(const table_type& tbl, std::type_identity_t<T_Symbol> /* epsilon_symbol */)
 		: m_table{ tbl }
-		, m_epsilon{ std::move(epsilon_symbol) }
 	{
 	}
 
@@ -168,20 +224,24 @@ public:
 		m_state_stack.clear();
 		m_state_stack.push_back(0);
 
+		m_error_state.reset();
 		m_is_finished = false;
+
+		m_column_token = no_token;
 	}
 
 	iter_range parse(std::span<const T_Symbol> input)
 	{
-		m_input = input;
-		m_input_ptr = 0;
+		begin(input);
 
-		m_state_stack.clear();
-		m_state_stack.push_back(0);
+		return iter_range{ *this };
+	}
 
-		m_is_finished = false;
+	record_range records(std::span<const T_Symbol> input)
+	{
+		begin(input);
 
-		return iter_range{ *this };
+		return record_range{ *this };
 	}
 
 	[[nodiscard]] bool is_finished() const
@@ -191,80 +251,54 @@ public:
 
 	[[nodiscard]] optional_event_type next()
 	{
-		if (m_is_finished)
+		const auto record = next_record();
+		if (!record)
 		{
 			return std::nullopt;
 		}
 
-		state_type current_state = m_state_stack.back();
-		T_Symbol current_token = (m_input_ptr < m_input.size())
-			? m_input[m_input_ptr]
-			: m_table.end_marker();
-
-		auto act = m_table.get_action(current_state, current_token);
-
-		return utility::overloaded_visitor(
-			act,
-			[&](const action_shift<state_type>& arg) -> std::optional<event_type> {
-				m_state_stack.emplace_back(arg.target_state);
-				if (m_input_ptr < m_input.size())
-				{
-					m_input_ptr++;
-				}
-
-				return event_shift<T_Symbol>{ current_token };
-			},
-			[&](const action_reduce<T_Symbol>& arg) -> std::optional<event_type> {
-				using opt_state = table_type::optional_state;
-
-				const auto& rule = arg.rule;
-				std::size_t pop_count = rule.rhs.size();
-
-				if (pop_count == 1 && rule.rhs[0] == m_epsilon)
-				{
-					pop_count = 0;
-				}
-
-				for (std::size_t i = 0; i < pop_count; ++i)
-				{
-					m_state_stack.pop_back();
-				}
-
-				state_type state_after_pop = m_state_stack.back();
-				opt_state next_state = m_table.get_goto(state_after_pop, rule.lhs);
-
-				if (!next_state.has_value())
-				{
-					m_is_finished = true;
+		switch (record->kind)
+		{
+		case event_kind::shift:
+			return event_shift<T_Symbol>{ token(*record) };
+		case event_kind::reduce:
+			return event_reduce{ record->rule_index, record->pop_count };
+		case event_kind::accept:
+			return event_accept{};
+		case event_kind::error:
+			break;
+		}
 
-					return event_error<T_Symbol>{ current_token };
-				}
+		return event_error<T_Symbol>{ token(*record), expected_tokens() };
+	}
 
-				m_state_stack.emplace_back(next_state.value());
+	[[nodiscard]] std::optional<event_record> next_record()
+	{
+		if (m_is_finished)
+		{
+			return std::nullopt;
+		}
 
-				return event_reduce<T_Symbol>{ rule, pop_count };
-			},
-			[&](const action_accept&) -> std::optional<event_type> {
-				m_is_finished = true;
+		return step();
+	}
 
-				return event_accept{};
-			},
-			[&](const action_error&) -> std::optional<event_type> {
-				m_is_finished = true;
+	/// The input token `record` points at, or the end marker past the input.
+	[[nodiscard]] const T_Symbol& token(const event_record& record) const
+	{
+		return record.token_index < m_input.size()
+			? m_input[record.token_index]
+			: m_table.end_marker();
+	}
 
-				std::vector<T_Symbol> expected_tokens;
-				const auto& row = m_table.action_table().at(current_state);
-				expected_tokens.reserve(row.size());
-				for (const auto& [terminal, action] : row)
-				{
-					if (!actions::is_error(action))
-					{
-						expected_tokens.emplace_back(terminal);
-					}
-				}
+	/// Terminals that would have been accepted where the last error was reported.
+	[[nodiscard]] std::vector<T_Symbol> expected_tokens() const
+	{
+		if (!m_error_state)
+		{
+			return {};
+		}
 
-				return event_error<T_Symbol>{ current_token, expected_tokens };
-			});
+		return m_table.expected_terminals(*m_error_state);
 	}
 
 	void recover(std::span<const T_Symbol> sync_tokens)
@@ -285,13 +319,9 @@ public:
 			m_input_ptr++;
 		}
 
-		T_Symbol sync_token = m_input_ptr < m_input.size()
-			? m_input[m_input_ptr]
-			: m_table.end_marker();
-
 		while (!m_state_stack.empty())
 		{
-			if (!actions::is_error(m_table.get_action(m_state_stack.back(), sync_token)))
+			if (!actions::is_error(action_at(m_state_stack.back(), m_input_ptr)))
 			{
 				return;
 			}
@@ -303,15 +333,111 @@ public:
 
 private:
 	const table_type& m_table;
-	T_Symbol m_epsilon;
 
 	std::span<const T_Symbol> m_input;
 	std::size_t m_input_ptr = 0;
 
+	std::optional<state_type> m_error_state;
+
 	std::vector<state_type> m_state_stack;
 	bool m_is_finished = true;
+
+	static constexpr std::size_t no_token = static_cast<std::size_t>(-1);
+
+	// The column of the token at `m_column_token`, for tables that intern terminals.
+	std::size_t m_column_token = no_token;
+	std::optional<terminal_column> m_column;
+
+	const auto& action_at(const state_type state, const std::size_t token_index)
+	{
+		const T_Symbol& current_token = token_index < m_input.size()
+			? m_input[token_index]
+			: m_table.end_marker();
+
+		if constexpr (requires { m_table.terminal_index(current_token); })
+		{
+			if (m_column_token != token_index)
+			{
+				m_column = m_table.terminal_index(current_token);
+				m_column_token = token_index;
+			}
+
+			return m_column ? m_table.get_action(state, *m_column) : m_table.actions().front();
+		}
+		else
+		{
+			return m_table.get_action(state, current_token);
+		}
+	}
+
+	event_record step()
+	{
+		const state_type current_state = m_state_stack.back();
+		const std::size_t token_index = m_input_ptr;
+
+		const auto& act = action_at(current_state, token_index);
+
+		return utility::overloaded_visitor(
+			act,
+			[&](const action_shift<state_type>& arg) {
+				m_state_stack.push_back(arg.target_state);
+				if (m_input_ptr < m_input.size())
+				{
+					m_input_ptr++;
+				}
+
+				return event_record{ .kind = event_kind::shift, .token_index = token_index };
+			},
+			[&](const action_reduce& arg) {
+				m_state_stack.resize(m_state_stack.size() - arg.pop_count);
+
+				const auto next_state = m_table.get_goto(m_state_stack.back(), arg);
+				if (!next_state.has_value())
+				{
+					m_is_finished = true;
+					m_error_state.reset();
+
+					return event_record{ .kind = event_kind::error, .token_index = token_index };
+				}
+
+				m_state_stack.push_back(*next_state);
+
+				return event_record{
+					.kind = event_kind::reduce,
+					.rule_index = arg.rule_index,
+					.pop_count = arg.pop_count,
+					.token_index = token_index,
+				};
+			},
+			[&](const action_accept&) {
+				m_is_finished = true;
+
+				return event_record{ .kind = event_kind::accept, .token_index = token_index };
+			},
+			[&](const action_error&) {
+				m_is_finished = true;
+				m_error_state = current_state;
+
+				return event_record{ .kind = event_kind::error, .token_index = token_index };
+			});
+	}
 };
 
+template <typename T_Symbol, typename T_Compare>
+parser(table<T_Symbol, T_Compare> const&)
+	-> parser<T_Symbol, T_Compare, table<T_Symbol, T_Compare>>;
+
+template <typename T_Symbol, typename T_Compare>
+parser(table<T_Symbol, T_Compare> const&, std::type_identity_t<T_Symbol>)
+	-> parser<T_Symbol, T_Compare, table<T_Symbol, T_Compare>>;
+
+template <typename T_Symbol, typename T_Compare>
+parser(compact_table<T_Symbol, T_Compare> const&)
+	-> parser<T_Symbol, T_Compare, compact_table<T_Symbol, T_Compare>>;
+
+template <typename T_Symbol, typename T_Compare>
+parser(compact_table<T_Symbol, T_Compare> const&, std::type_identity_t<T_Symbol>)
+	-> parser<T_Symbol, T_Compare, compact_table<T_Symbol, T_Compare>>;
 } // namespace fsm::lr
 
 #endif // FSM_SLR_PARSER_HPP
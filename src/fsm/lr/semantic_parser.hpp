@@ -0,0 +1,142 @@
+#ifndef FSM_LR_SEMANTIC_PARSER_HPP
+#define FSM_LR_SEMANTIC_PARSER_HPP
+
+#include "parser.hpp"
+
+#include <algorithm>
+#include <expected>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace fsm::lr
+{
+/**
+ * @brief Drives `lr::parser` and keeps a semantic value per stack entry.
+ *
+ * A shifted token becomes a value through the shift callback; a reduction
+ * replaces the values of the rule's right-hand side with the result of the
+ * callback registered for that rule, or of the default one. Without any
+ * callback a reduction keeps its first value, or `T_Value{}` for ε-rules.
+ * `parse` returns the value of the start symbol.
+ */
+template <typename T_Value, typename T_Table>
+class semantic_parser
+{
+public:
+	using table_type = T_Table;
+	using symbol_type = typename table_type::symbol_type;
+	using value_type = T_Value;
+	using error_type = event_error<symbol_type>;
+
+	using shift_callback_type = std::function<T_Value(const symbol_type& token, std::size_t token_index)>;
+	using reduce_callback_type = std::function<T_Value(std::span<T_Value> rhs)>;
+	using default_reduce_callback_type = std::function<T_Value(const event_record& reduce, std::span<T_Value> rhs)>;
+
+	explicit semantic_parser(const table_type& tbl)
+		: m_parser{ tbl }
+		, m_table{ tbl }
+		, m_reduce_callbacks(tbl.rules().size())
+	{
+	}
+
+	semantic_parser& on_shift(shift_callback_type callback)
+	{
+		m_shift_callback = std::move(callback);
+
+		return *this;
+	}
+
+	semantic_parser& on_reduce(const std::size_t rule_index, reduce_callback_type callback)
+	{
+		if (rule_index >= m_reduce_callbacks.size())
+		{
+			throw std::out_of_range("Rule index " + std::to_string(rule_index) + " is not in the table");
+		}
+
+		m_reduce_callbacks[rule_index] = std::move(callback);
+
+		return *this;
+	}
+
+	semantic_parser& on_reduce(const cfg_rule<symbol_type>& rule, reduce_callback_type callback)
+	{
+		const auto it = std::ranges::find(m_table.rules(), rule);
+		if (it == m_table.rules().end())
+		{
+			throw std::invalid_argument("Rule is not in the table");
+		}
+
+		return on_reduce(static_cast<std::size_t>(it - m_table.rules().begin()), std::move(callback));
+	}
+
+	semantic_parser& on_default_reduce(default_reduce_callback_type callback)
+	{
+		m_default_reduce_callback = std::move(callback);
+
+		return *this;
+	}
+
+	std::expected<T_Value, error_type> parse(std::span<const symbol_type> input)
+	{
+		m_values.clear();
+
+		for (const auto record : m_parser.records(input))
+		{
+			switch (record.kind)
+			{
+			case event_kind::shift:
+				m_values.push_back(m_shift_callback
+						? m_shift_callback(m_parser.token(record), record.token_index)
+						: T_Value{});
+				break;
+			case event_kind::reduce:
+				reduce(record);
+				break;
+			case event_kind::accept:
+				return std::move(m_values.back());
+			case event_kind::error:
+				return std::unexpected(error_type{ m_parser.token(record), m_parser.expected_tokens() });
+			}
+		}
+
+		return std::unexpected(error_type{ m_table.end_marker(), {} });
+	}
+
+private:
+	parser<symbol_type, typename table_type::compare_type, table_type> m_parser;
+	const table_type& m_table;
+
+	shift_callback_type m_shift_callback;
+	std::vector<reduce_callback_type> m_reduce_callbacks;
+	default_reduce_callback_type m_default_reduce_callback;
+
+	std::vector<T_Value> m_values;
+
+	void reduce(const event_record& record)
+	{
+		const auto first = m_values.end() - record.pop_count;
+		const std::span<T_Value> rhs(first, m_values.end());
+
+		T_Value result;
+		if (auto const& callback = m_reduce_callbacks[record.rule_index])
+		{
+			result = callback(rhs);
+		}
+		else if (m_default_reduce_callback)
+		{
+			result = m_default_reduce_callback(record, rhs);
+		}
+		else
+		{
+			result = rhs.empty() ? T_Value{} : std::move(rhs.front());
+		}
+
+		m_values.erase(first, m_values.end());
+		m_values.push_back(std::move(result));
+	}
+};
+} // namespace fsm::lr
+
+#endif // FSM_LR_SEMANTIC_PARSER_HPP
@@ -3,63 +3,81 @@
 
 #include "../cfg/basic_cfg.hpp"
 
+#include <algorithm>
+#include <cstdint>
 #include <map>
+#include <optional>
+#include <span>
 #include <variant>
+#include <vector>
 
 namespace fsm::lr
 {
 struct action_error
 {
+	bool operator==(const action_error&) const = default;
 };
 
 struct action_accept
 {
+	bool operator==(const action_accept&) const = default;
 };
 
 template <typename T_State>
 struct action_shift
 {
 	T_State target_state;
+
+	bool operator==(const action_shift&) const = default;
 };
 
-template <typename T_Symbol>
+/**
+ * @brief Reduce by rule `rule_index` of the owning table.
+ *
+ * The number of states to pop and the goto column of the rule's left-hand side
+ * are precomputed, so reducing never touches the rule itself.
+ */
 struct action_reduce
 {
-	cfg_rule<T_Symbol> rule;
+	std::uint32_t rule_index{};
+	std::uint32_t pop_count{};
+	std::uint32_t lhs_column{};
+
+	bool operator==(const action_reduce&) const = default;
 };
 
-template <typename T_Symbol, typename T_State>
+template <typename T_State>
 using action = std::variant<
 	action_error,
 	action_accept,
 	action_shift<T_State>,
-	action_reduce<T_Symbol>>;
+	action_reduce>;
 
 namespace actions
 {
-template <typename T_Symbol, typename T_State>
-bool is_error(const action<T_Symbol, T_State>& act) { return std::holds_alternative<action_error>(act); }
+template <typename T_State>
+bool is_error(const action<T_State>& act) { return std::holds_alternative<action_error>(act); }
 
-template <typename T_Symbol, typename T_State>
-bool is_accept(const action<T_Symbol, T_State>& act) { return std::holds_alternative<action_accept>(act); }
+template <typename T_State>
+bool is_accept(const action<T_State>& act) { return std::holds_alternative<action_accept>(act); }
 
-template <typename T_Symbol, typename T_State>
-bool is_shift(const action<T_Symbol, T_State>& act) { return std::holds_alternative<action_shift<T_State>>(act); }
+template <typename T_State>
+bool is_shift(const action<T_State>& act) { return std::holds_alternative<action_shift<T_State>>(act); }
 
-template <typename T_Symbol, typename T_State>
-bool is_reduce(const action<T_Symbol, T_State>& act) { return std::holds_alternative<action_reduce<T_Symbol>>(act); }
+template <typename T_State>
+bool is_reduce(const action<T_State>& act) { return std::holds_alternative<action_reduce>(act); }
 
-template <typename T_Symbol, typename T_State>
-action_error as_error(const action<T_Symbol, T_State>& act) { return std::get<action_error>(act); }
+template <typename T_State>
+action_error as_error(const action<T_State>& act) { return std::get<action_error>(act); }
 
-template <typename T_Symbol, typename T_State>
-action_accept as_accept(const action<T_Symbol, T_State>& act) { return std::get<action_accept>(act); }
+template <typename T_State>
+action_accept as_accept(const action<T_State>& act) { return std::get<action_accept>(act); }
 
-template <typename T_Symbol, typename T_State>
-action_shift<T_State> as_shift(const action<T_Symbol, T_State>& act) { return std::get<action_shift<T_State>>(act); }
+template <typename T_State>
+action_shift<T_State> as_shift(const action<T_State>& act) { return std::get<action_shift<T_State>>(act); }
 
-template <typename T_Symbol, typename T_State>
-action_reduce<T_Symbol> as_reduce(const action<T_Symbol, T_State>& act) { return std::get<action_reduce<T_Symbol>>(act); }
+template <typename T_State>
+action_reduce as_reduce(const action<T_State>& act) { return std::get<action_reduce>(act); }
 } // namespace actions
 
 template <typename T_Symbol, typename T_Compare = std::less<T_Symbol>>
@@ -69,19 +87,23 @@ class table
 	static_assert(std::is_integral_v<state_t> && std::is_convertible_v<state_t, std::size_t>,
 		"state_t must be integral and convertable to std::size_t");
 
-	using action_t = action<T_Symbol, state_t>;
+	using action_t = action<state_t>;
 
 	using action_map_t = std::map<T_Symbol, action_t, T_Compare>;
 	using goto_map_t = std::map<T_Symbol, state_t, T_Compare>;
+	using conflict_map_t = std::map<T_Symbol, std::vector<action_t>, T_Compare>;
 
 public:
 	using action_type = action_t;
 	using symbol_type = T_Symbol;
+	using compare_type = T_Compare;
 	using state_type = state_t;
 	using optional_state = std::optional<state_type>;
+	using rule_type = cfg_rule<T_Symbol>;
 
 	using action_table_type = std::map<state_type, action_map_t>;
 	using goto_table_type = std::map<state_type, goto_map_t>;
+	using conflict_table_type = std::map<state_type, conflict_map_t>;
 
 	static constexpr state_type invalid_state = static_cast<state_type>(-1);
 
@@ -90,11 +112,75 @@ public:
 		m_action_table[state][terminal] = act;
 	}
 
+	/**
+	 * Keeps `act` next to the action already in the cell instead of replacing
+	 * it. `get_action` still returns the cell's action; a GLR parser also
+	 * follows `conflicting_actions`.
+	 */
+	void add_conflict(const state_type state, const T_Symbol& terminal, const action_type& act)
+	{
+		const auto& existing = get_action(state, terminal);
+		if (actions::is_error(existing))
+		{
+			add_action(state, terminal, act);
+			return;
+		}
+
+		if (existing == act)
+		{
+			return;
+		}
+
+		auto& alternatives = m_conflict_table[state][terminal];
+		if (std::ranges::find(alternatives, act) == alternatives.end())
+		{
+			alternatives.push_back(act);
+		}
+	}
+
 	void add_goto(const state_type state, const T_Symbol& non_terminal, state_type target_state)
 	{
+		non_terminal_column(non_terminal);
 		m_goto_table[state][non_terminal] = target_state;
 	}
 
+	/// Index of `rule` in `rules()`, registering it on first use.
+	std::uint32_t add_rule(const rule_type& rule)
+	{
+		const auto [it, inserted] = m_rule_ids.try_emplace(rule, static_cast<std::uint32_t>(m_rules.size()));
+		if (inserted)
+		{
+			non_terminal_column(rule.lhs);
+			m_rules.push_back(rule);
+		}
+
+		return it->second;
+	}
+
+	/// Goto column of `non_terminal` in `non_terminals()`, registering it on first use.
+	std::uint32_t non_terminal_column(const T_Symbol& non_terminal)
+	{
+		const auto [it, inserted] = m_non_terminal_columns.try_emplace(non_terminal, static_cast<std::uint32_t>(m_non_terminals.size()));
+		if (inserted)
+		{
+			m_non_terminals.push_back(non_terminal);
+		}
+
+		return it->second;
+	}
+
+	/// A reduce action by `rule`; a rule whose only symbol is `epsilon` pops nothing.
+	action_reduce make_reduce(const rule_type& rule, const T_Symbol& epsilon)
+	{
+		const bool is_epsilon = rule.rhs.empty() || (rule.rhs.size() == 1 && rule.rhs[0] == epsilon);
+
+		return action_reduce{
+			.rule_index = add_rule(rule),
+			.pop_count = is_epsilon ? 0u : static_cast<std::uint32_t>(rule.rhs.size()),
+			.lhs_column = non_terminal_column(rule.lhs),
+		};
+	}
+
 	const action_type& get_action(const state_type state, const T_Symbol& terminal) const
 	{
 		static const action_type default_error = action_error{};
@@ -112,11 +198,66 @@ public:
 		return get_action(*state, terminal);
 	}
 
+	/// Actions kept by `add_conflict` besides `get_action(state, terminal)`.
+	std::span<const action_type> conflicting_actions(const state_type state, const T_Symbol& terminal) const
+	{
+		if (auto state_it = m_conflict_table.find(state); state_it != m_conflict_table.end())
+		{
+			if (auto conflict_it = state_it->second.find(terminal); conflict_it != state_it->second.end())
+			{
+				return conflict_it->second;
+			}
+		}
+
+		return {};
+	}
+
 	optional_state get_goto(const state_type state, const T_Symbol& non_terminal) const
 	{
 		return find_goto(state, non_terminal);
 	}
 
+	/// The state entered after `reduce` uncovers `state`.
+	optional_state get_goto(const state_type state, const action_reduce& reduce) const
+	{
+		return find_goto(state, m_non_terminals[reduce.lhs_column]);
+	}
+
+	const rule_type& rule(const std::size_t rule_index) const
+	{
+		return m_rules[rule_index];
+	}
+
+	const std::vector<rule_type>& rules() const
+	{
+		return m_rules;
+	}
+
+	/// Non-terminals in goto column order.
+	const std::vector<T_Symbol>& non_terminals() const
+	{
+		return m_non_terminals;
+	}
+
+	/// Terminals with a non-error action in `state`, in `T_Compare` order.
+	[[nodiscard]] std::vector<T_Symbol> expected_terminals(const state_type state) const
+	{
+		std::vector<T_Symbol> expected;
+		if (auto state_it = m_action_table.find(state); state_it != m_action_table.end())
+		{
+			expected.reserve(state_it->second.size());
+			for (const auto& [terminal, act] : state_it->second)
+			{
+				if (!actions::is_error(act))
+				{
+					expected.push_back(terminal);
+				}
+			}
+		}
+
+		return expected;
+	}
+
 	table& set_end_marker(T_Symbol eof)
 	{
 		m_eof = std::move(eof);
@@ -139,11 +280,22 @@ public:
 		return m_goto_table;
 	}
 
+	const conflict_table_type& conflict_table() const
+	{
+		return m_conflict_table;
+	}
+
 private:
 	action_table_type m_action_table;
 	goto_table_type m_goto_table;
+	conflict_table_type m_conflict_table;
 	T_Symbol m_eof;
 
+	std::vector<rule_type> m_rules;
+	std::map<rule_type, std::uint32_t> m_rule_ids;
+	std::vector<T_Symbol> m_non_terminals;
+	std::map<T_Symbol, std::uint32_t, T_Compare> m_non_terminal_columns;
+
 	const action_type& find_action(state_type state, const T_Symbol& symbol, const action_type& default_val) const
 	{
 		if (auto state_it = m_action_table.find(state); state_it != m_action_table.end())
@@ -5,12 +5,20 @@
 #include "../utility.hpp"
 #include "table.hpp"
 
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 
 namespace fsm::lr::io
 {
+/// Bumped whenever the binary layout written by `save_to_binary` changes.
+inline constexpr std::uint32_t table_format_version = 1;
+
 namespace detail
 {
+inline constexpr char table_magic[8] = { 'F', 'S', 'M', 'L', 'R', 'T', 'B', '\0' };
 template <typename T>
 void write_bin(std::ostream& os, const T& val)
 {
@@ -60,15 +68,93 @@ void read_bin(std::istream& is, T& val)
 		static_assert(sizeof(T) == 0, "Type is not deserializable.");
 	}
 }
+
+template <typename T_State>
+void write_action(std::ostream& os, const action<T_State>& act)
+{
+	const std::size_t act_idx = act.index();
+	write_bin(os, act_idx);
+
+	utility::overloaded_visitor(
+		act,
+		[&](const action_error&) {},
+		[&](const action_accept&) {},
+		[&](const action_shift<T_State>& s) {
+			write_bin(os, s.target_state);
+		},
+		[&](const action_reduce& r) {
+			write_bin(os, r);
+		});
+}
+
+template <typename T_State>
+action<T_State> read_action(std::istream& is)
+{
+	std::size_t act_idx = 0;
+	read_bin(is, act_idx);
+
+	if (act_idx == 1)
+	{
+		return action_accept{};
+	}
+	if (act_idx == 2)
+	{
+		T_State target;
+		read_bin(is, target);
+		return action_shift<T_State>{ target };
+	}
+	if (act_idx == 3)
+	{
+		action_reduce reduce;
+		read_bin(is, reduce);
+		return reduce;
+	}
+
+	return action_error{};
+}
+
+template <typename T_Symbol, typename T_Compare, typename T_State>
+action<T_State> checked_action(const table<T_Symbol, T_Compare>& tbl, action<T_State> act)
+{
+	if (const auto* reduce = std::get_if<action_reduce>(&act))
+	{
+		if (reduce->rule_index >= tbl.rules().size() || reduce->lhs_column >= tbl.non_terminals().size())
+		{
+			throw std::runtime_error("LR table: reduce action refers to rule " + std::to_string(reduce->rule_index)
+				+ " and goto column " + std::to_string(reduce->lhs_column) + ", which are not in the table");
+		}
+	}
+
+	return act;
+}
 } // namespace detail
 
 template <typename T_Symbol, typename T_Compare>
 void save_to_binary(const table<T_Symbol, T_Compare>& tbl, std::ostream& os)
 {
-	using state_t = typename table<T_Symbol, T_Compare>::state_type;
-
+	os.write(detail::table_magic, sizeof(detail::table_magic));
+	detail::write_bin(os, table_format_version);
 	detail::write_bin(os, tbl.end_marker());
 
+	const auto& non_terminals = tbl.non_terminals();
+	detail::write_bin(os, non_terminals.size());
+	for (const auto& sym : non_terminals)
+	{
+		detail::write_bin(os, sym);
+	}
+
+	const auto& rules = tbl.rules();
+	detail::write_bin(os, rules.size());
+	for (const auto& rule : rules)
+	{
+		detail::write_bin(os, rule.lhs);
+		detail::write_bin(os, rule.rhs.size());
+		for (const auto& rs : rule.rhs)
+		{
+			detail::write_bin(os, rs);
+		}
+	}
+
 	const auto& action_tbl = tbl.action_table();
 	const std::size_t action_size = action_tbl.size();
 	detail::write_bin(os, action_size);
@@ -82,26 +168,7 @@ void save_to_binary(const table<T_Symbol, T_Compare>& tbl, std::ostream& os)
 		for (const auto& [sym, act] : row)
 		{
 			detail::write_bin(os, sym);
-
-			const std::size_t act_idx = act.index();
-			detail::write_bin(os, act_idx);
-
-			utility::overloaded_visitor(
-				act,
-				[&](const action_error&) {},
-				[&](const action_accept&) {},
-				[&](const action_shift<state_t>& s) {
-					detail::write_bin(os, s.target_state);
-				},
-				[&](const action_reduce<T_Symbol>& r) {
-					detail::write_bin(os, r.rule.lhs);
-					const size_t rhs_size = r.rule.rhs.size();
-					detail::write_bin(os, rhs_size);
-					for (const auto& rs : r.rule.rhs)
-					{
-						detail::write_bin(os, rs);
-					}
-				});
+			detail::write_action(os, act);
 		}
 	}
 
@@ -121,18 +188,80 @@ void save_to_binary(const table<T_Symbol, T_Compare>& tbl, std::ostream& os)
 			detail::write_bin(os, target);
 		}
 	}
+
+	const auto& conflict_tbl = tbl.conflict_table();
+	detail::write_bin(os, conflict_tbl.size());
+
+	for (const auto& [state, row] : conflict_tbl)
+	{
+		detail::write_bin(os, state);
+		detail::write_bin(os, row.size());
+
+		for (const auto& [sym, alternatives] : row)
+		{
+			detail::write_bin(os, sym);
+			detail::write_bin(os, alternatives.size());
+			for (const auto& act : alternatives)
+			{
+				detail::write_action(os, act);
+			}
+		}
+	}
 }
 
+/// Throws `std::runtime_error` if `is` does not hold a table of this format
+/// version, or if a reduce action names a rule or goto column it lacks.
 template <typename T_Symbol, typename T_Compare = std::less<T_Symbol>>
 table<T_Symbol, T_Compare> load_from_binary(std::istream& is)
 {
 	using state_t = typename table<T_Symbol, T_Compare>::state_type;
 	table<T_Symbol, T_Compare> tbl;
 
+	char magic[sizeof(detail::table_magic)]{};
+	is.read(magic, sizeof(magic));
+	if (!is || std::memcmp(magic, detail::table_magic, sizeof(magic)) != 0)
+	{
+		throw std::runtime_error("LR table: not a binary LR table");
+	}
+
+	std::uint32_t version = 0;
+	detail::read_bin(is, version);
+	if (version != table_format_version)
+	{
+		throw std::runtime_error("LR table: format version " + std::to_string(version) + " is not supported, expected "
+			+ std::to_string(table_format_version));
+	}
+
 	T_Symbol eof;
 	detail::read_bin(is, eof);
 	tbl.set_end_marker(eof);
 
+	// Columns first: registering the rules afterwards must not renumber them.
+	std::size_t non_terminals_size = 0;
+	detail::read_bin(is, non_terminals_size);
+	for (std::size_t i = 0; i < non_terminals_size; ++i)
+	{
+		T_Symbol sym;
+		detail::read_bin(is, sym);
+		tbl.non_terminal_column(sym);
+	}
+
+	std::size_t rules_size = 0;
+	detail::read_bin(is, rules_size);
+	for (std::size_t i = 0; i < rules_size; ++i)
+	{
+		cfg_rule<T_Symbol> rule;
+		detail::read_bin(is, rule.lhs);
+		std::size_t rhs_size;
+		detail::read_bin(is, rhs_size);
+		rule.rhs.resize(rhs_size);
+		for (std::size_t k = 0; k < rhs_size; ++k)
+		{
+			detail::read_bin(is, rule.rhs[k]);
+		}
+		tbl.add_rule(rule);
+	}
+
 	std::size_t action_tbl_size = 0;
 	detail::read_bin(is, action_tbl_size);
 
@@ -146,37 +275,8 @@ table<T_Symbol, T_Compare> load_from_binary(std::istream& is)
 		for (std::size_t j = 0; j < row_size; ++j)
 		{
 			T_Symbol sym;
-			std::size_t act_idx;
 			detail::read_bin(is, sym);
-			detail::read_bin(is, act_idx);
-
-			if (act_idx == 0)
-			{
-				tbl.add_action(state, sym, action_error{});
-			}
-			else if (act_idx == 1)
-			{
-				tbl.add_action(state, sym, action_accept{});
-			}
-			else if (act_idx == 2)
-			{
-				state_t target;
-				detail::read_bin(is, target);
-				tbl.add_action(state, sym, action_shift<state_t>{ target });
-			}
-			else if (act_idx == 3)
-			{
-				cfg_rule<T_Symbol> rule;
-				detail::read_bin(is, rule.lhs);
-				std::size_t rhs_size;
-				detail::read_bin(is, rhs_size);
-				rule.rhs.resize(rhs_size);
-				for (std::size_t k = 0; k < rhs_size; ++k)
-				{
-					detail::read_bin(is, rule.rhs[k]);
-				}
-				tbl.add_action(state, sym, action_reduce<T_Symbol>{ std::move(rule) });
-			}
+			tbl.add_action(state, sym, detail::checked_action(tbl, detail::read_action<state_t>(is)));
 		}
 	}
 
@@ -200,6 +300,29 @@ table<T_Symbol, T_Compare> load_from_binary(std::istream& is)
 		}
 	}
 
+	std::size_t conflict_tbl_size = 0;
+	detail::read_bin(is, conflict_tbl_size);
+
+	for (std::size_t i = 0; i < conflict_tbl_size; ++i)
+	{
+		state_t state;
+		std::size_t row_size;
+		detail::read_bin(is, state);
+		detail::read_bin(is, row_size);
+
+		for (std::size_t j = 0; j < row_size; ++j)
+		{
+			T_Symbol sym;
+			std::size_t alternatives_size;
+			detail::read_bin(is, sym);
+			detail::read_bin(is, alternatives_size);
+			for (std::size_t k = 0; k < alternatives_size; ++k)
+			{
+				tbl.add_conflict(state, sym, detail::checked_action(tbl, detail::read_action<state_t>(is)));
+			}
+		}
+	}
+
 	return tbl;
 }
 } // namespace fsm::lr::io
@@ -0,0 +1,13 @@
+#ifndef FSM_LR1_HPP
+#define FSM_LR1_HPP
+
+#include "lr/ast_builder.hpp"
+#include "lr/compact_table.hpp"
+#include "lr/incremental_parser.hpp"
+#include "lr/parser.hpp"
+#include "lr/semantic_parser.hpp"
+#include "lr/table.hpp"
+#include "lr/table_io.hpp"
+#include "lr1/table_builder.hpp"
+
+#endif // FSM_LR1_HPP
@@ -0,0 +1,309 @@
+#ifndef FSM_LR1_TABLE_BUILDER_HPP
+#define FSM_LR1_TABLE_BUILDER_HPP
+
+#include "../cfg/cfg_algorithms.hpp"
+#include "../lr/basic_table_builder.hpp"
+#include "../lr/item_grammar.hpp"
+#include "../lr/lr0_item.hpp"
+#include "../lr/table.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <expected>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace fsm::lr1
+{
+/// Sizes of a table built by `lr1::table_builder`.
+struct build_stats
+{
+	std::size_t state_count{};
+	/// States of the LALR(1) table of the same grammar: one per LR(0) core.
+	std::size_t lalr_state_count{};
+
+	/// States added by splitting LALR(1) states whose merge would conflict.
+	[[nodiscard]] std::size_t split_states() const
+	{
+		return state_count - lalr_state_count;
+	}
+};
+
+/**
+ * @brief Builds LR(1) tables of nearly LALR(1) size with Pager's method.
+ *
+ * States are generated from kernels with lookaheads, and a new state is merged
+ * into an existing one with the same core when the two are weakly compatible
+ * (Pager, "A Practical General Method for Constructing LR(k) Parsers", 1977).
+ * Such merges never create a conflict that canonical LR(1) would not have, so
+ * every LR(1) grammar gets a table. Weak compatibility is conservative, but
+ * grammars that are LALR(1) rarely get more states than their LALR(1) table.
+ */
+template <typename T_Symbol, typename T_Compare = std::less<T_Symbol>>
+class table_builder : public lr::basic_table_builder<table_builder<T_Symbol, T_Compare>, T_Symbol, T_Compare>
+{
+	using base_t = lr::basic_table_builder<table_builder, T_Symbol, T_Compare>;
+
+	using typename base_t::first_sets_t;
+	using typename base_t::item_grammar_t;
+	using typename base_t::kernel_t;
+	using typename base_t::lookaheads_t;
+	using typename base_t::lr1_state_t;
+	using typename base_t::transitions_t;
+
+	using symbol_id = typename item_grammar_t::symbol_id;
+
+public:
+	explicit table_builder(const basic_cfg<T_Symbol, T_Compare>& grammar)
+		: base_t(grammar)
+	{
+	}
+
+	table_builder(
+		base_t::grammar_type const& grammar,
+		base_t::identity_symbol epsilon,
+		base_t::identity_symbol end_marker,
+		base_t::identity_symbol aug_start)
+		: base_t(grammar, std::move(epsilon), std::move(end_marker), std::move(aug_start))
+	{
+	}
+
+	template <typename T_CollisionPolicy = lr::detail::strict_t>
+	std::expected<typename base_t::table_type, std::vector<lr::conflict_error<T_Symbol>>>
+	build(T_CollisionPolicy policy = lr::collision_policy::strict) const
+	{
+		build_stats stats;
+
+		return build(policy, stats);
+	}
+
+	/**
+	 * Merges states while generating them, then recomputes the lookaheads of
+	 * the final automaton by propagation, which drops those a state picked up
+	 * from successors it had before being revisited. States are numbered in
+	 * breadth-first order, as `lalr::table_builder` does.
+	 */
+	template <typename T_CollisionPolicy>
+	std::expected<typename base_t::table_type, std::vector<lr::conflict_error<T_Symbol>>>
+	build(T_CollisionPolicy policy, build_stats& stats) const
+	{
+		typename base_t::table_type result;
+
+		result.set_end_marker(this->m_eof);
+		std::vector<lr::conflict_error<T_Symbol>> errors;
+
+		const auto first_sets = algorithms::compute_first(this->m_grammar, this->m_epsilon);
+		const auto items = this->make_item_grammar();
+
+		const auto [kernels, transitions] = build_automaton(first_sets, items);
+		const auto kernel_lookaheads = this->compute_lookaheads(kernels, transitions, first_sets, items);
+
+		stats.state_count = kernels.size();
+		stats.lalr_state_count = std::unordered_set<kernel_t, typename kernel_t::hasher>(kernels.begin(), kernels.end()).size();
+
+		std::vector<lr1_state_t> states(kernels.size());
+		for (std::size_t i = 0; i < kernels.size(); ++i)
+		{
+			for (std::size_t k = 0; k < kernels[i].size(); ++k)
+			{
+				states[i][kernels[i][k]] = kernel_lookaheads[i][k];
+			}
+			states[i] = this->compute_closure(std::move(states[i]), first_sets, items);
+		}
+
+		this->add_lr1_actions(result, states, transitions, items, policy, errors);
+
+		if constexpr (std::is_same_v<T_CollisionPolicy, lr::detail::strict_t>)
+		{
+			if (!errors.empty())
+			{
+				return std::unexpected(std::move(errors));
+			}
+		}
+
+		return result;
+	}
+
+	/// Same as `build`, frozen into an `lr::compact_table` for parsing.
+	template <typename T_CollisionPolicy = lr::detail::strict_t>
+	std::expected<typename base_t::compact_table_type, std::vector<lr::conflict_error<T_Symbol>>>
+	build_compact(T_CollisionPolicy policy = lr::collision_policy::strict) const
+	{
+		auto result = build(policy);
+		if (!result)
+		{
+			return std::unexpected(std::move(result.error()));
+		}
+
+		return typename base_t::compact_table_type(*result);
+	}
+
+private:
+	struct pager_state
+	{
+		kernel_t kernel;
+		std::vector<lookaheads_t> lookaheads;
+		std::map<symbol_id, std::size_t> gotos;
+	};
+
+	using states_by_core_t = std::unordered_map<kernel_t, std::vector<std::size_t>, typename kernel_t::hasher>;
+
+	struct automaton
+	{
+		std::vector<kernel_t> kernels;
+		transitions_t transitions;
+	};
+
+	static bool intersects(lookaheads_t const& a, lookaheads_t const& b)
+	{
+		auto const& [small, large] = a.size() <= b.size() ? std::tie(a, b) : std::tie(b, a);
+
+		return std::ranges::any_of(small, [&](T_Symbol const& s) { return large.contains(s); });
+	}
+
+	/// Pager's weak compatibility of two lookahead vectors over the same core.
+	static bool weakly_compatible(std::vector<lookaheads_t> const& a, std::vector<lookaheads_t> const& b)
+	{
+		for (std::size_t i = 0; i < a.size(); ++i)
+		{
+			for (std::size_t j = i + 1; j < a.size(); ++j)
+			{
+				if ((intersects(a[i], b[j]) || intersects(b[i], a[j]))
+					&& !intersects(a[i], a[j])
+					&& !intersects(b[i], b[j]))
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	/// Returns the state for `kernel` with `lookaheads`, and whether its lookaheads changed.
+	std::pair<std::size_t, bool> merge_or_add(
+		std::vector<pager_state>& states,
+		states_by_core_t& states_by_core,
+		kernel_t kernel,
+		std::vector<lookaheads_t> lookaheads) const
+	{
+		auto& same_core = states_by_core[kernel];
+		for (const std::size_t id : same_core)
+		{
+			auto& existing = states[id].lookaheads;
+			if (!weakly_compatible(existing, lookaheads))
+			{
+				continue;
+			}
+
+			bool grown = false;
+			for (std::size_t k = 0; k < existing.size(); ++k)
+			{
+				const std::size_t old_size = existing[k].size();
+				existing[k].insert(lookaheads[k].begin(), lookaheads[k].end());
+				grown = grown || existing[k].size() != old_size;
+			}
+
+			return { id, grown };
+		}
+
+		same_core.push_back(states.size());
+		states.push_back({ std::move(kernel), std::move(lookaheads), {} });
+
+		return { states.size() - 1, true };
+	}
+
+	automaton build_automaton(first_sets_t const& first_sets, item_grammar_t const& items) const
+	{
+		std::vector<pager_state> states;
+		states_by_core_t states_by_core;
+		merge_or_add(states, states_by_core, kernel_t({ items.start_item() }), { { this->m_eof } });
+
+		std::deque<std::size_t> pending{ 0 };
+		std::vector<bool> queued{ true };
+		while (!pending.empty())
+		{
+			const std::size_t current_id = pending.front();
+			pending.pop_front();
+			queued[current_id] = false;
+
+			lr1_state_t closure;
+			for (std::size_t k = 0; k < states[current_id].kernel.size(); ++k)
+			{
+				closure[states[current_id].kernel[k]] = states[current_id].lookaheads[k];
+			}
+			closure = this->compute_closure(std::move(closure), first_sets, items);
+
+			// Symbol ids follow `T_Compare`, so targets are visited in the order `lalr::table_builder` numbers them.
+			std::map<symbol_id, lr1_state_t> gotos;
+			for (const auto& [item, lookaheads] : closure)
+			{
+				if (!items.is_complete(item) && !items.is_epsilon(items.next_symbol_id(item)))
+				{
+					gotos[items.next_symbol_id(item)][item.advanced()].insert(lookaheads.begin(), lookaheads.end());
+				}
+			}
+
+			for (auto& [X, goto_items] : gotos)
+			{
+				std::vector<lr::lr0_item> kernel;
+				std::vector<lookaheads_t> lookaheads;
+				for (auto& [item, item_lookaheads] : goto_items)
+				{
+					kernel.push_back(item);
+					lookaheads.push_back(std::move(item_lookaheads));
+				}
+
+				const auto [target, changed] = merge_or_add(states, states_by_core, kernel_t(std::move(kernel)), std::move(lookaheads));
+				states[current_id].gotos[X] = target;
+
+				queued.resize(states.size(), false);
+				if (changed && !queued[target])
+				{
+					queued[target] = true;
+					pending.push_back(target);
+				}
+			}
+		}
+
+		// Revisited states may have left targets unreachable; keep and number the rest breadth-first.
+		constexpr auto unnumbered = static_cast<std::size_t>(-1);
+		std::vector<std::size_t> new_ids(states.size(), unnumbered);
+		std::vector<std::size_t> order{ 0 };
+		new_ids[0] = 0;
+		for (std::size_t i = 0; i < order.size(); ++i)
+		{
+			for (const auto& [X, target] : states[order[i]].gotos)
+			{
+				if (new_ids[target] == unnumbered)
+				{
+					new_ids[target] = order.size();
+					order.push_back(target);
+				}
+			}
+		}
+
+		automaton result;
+		for (const std::size_t old_id : order)
+		{
+			for (const auto& [X, target] : states[old_id].gotos)
+			{
+				result.transitions[{ new_ids[old_id], items.symbol(X) }] = new_ids[target];
+			}
+			result.kernels.push_back(std::move(states[old_id].kernel));
+		}
+
+		return result;
+	}
+};
+
+template <typename T_Symbol, typename T_Compare>
+table_builder(basic_cfg<T_Symbol, T_Compare> const&) -> table_builder<T_Symbol, T_Compare>;
+
+} // namespace fsm::lr1
+
+#endif // FSM_LR1_TABLE_BUILDER_HPP
@@ -0,0 +1,280 @@
+#ifndef FSM_MAPPED_SOURCE_HPP
+#define FSM_MAPPED_SOURCE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <spanstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FSM_MAPPED_SOURCE_POSIX
+#elif defined(_WIN32)
+struct _SECURITY_ATTRIBUTES;
+
+namespace fsm::detail::win32
+{
+// The few kernel32 calls `mapped_source` needs, declared here so that <windows.h> and its macros stay out of user code.
+extern "C"
+{
+	__declspec(dllimport) void* __stdcall CreateFileW(const wchar_t*, unsigned long, unsigned long, ::_SECURITY_ATTRIBUTES*, unsigned long, unsigned long, void*);
+	__declspec(dllimport) void* __stdcall CreateFileMappingW(void*, ::_SECURITY_ATTRIBUTES*, unsigned long, unsigned long, unsigned long, const wchar_t*);
+	__declspec(dllimport) unsigned long __stdcall GetFileSize(void*, unsigned long*);
+	__declspec(dllimport) unsigned long __stdcall GetLastError();
+	__declspec(dllimport) void* __stdcall MapViewOfFile(void*, unsigned long, unsigned long, unsigned long, std::size_t);
+	__declspec(dllimport) int __stdcall UnmapViewOfFile(const void*);
+	__declspec(dllimport) int __stdcall CloseHandle(void*);
+}
+
+inline constexpr unsigned long generic_read = 0x80000000ul;
+inline constexpr unsigned long file_share_read = 0x1ul;
+inline constexpr unsigned long open_existing = 3ul;
+inline constexpr unsigned long file_flag_sequential_scan = 0x08000000ul;
+inline constexpr unsigned long page_readonly = 0x2ul;
+inline constexpr unsigned long file_map_read = 0x4ul;
+inline constexpr unsigned long invalid_file_size = 0xFFFFFFFFul;
+
+inline void* invalid_handle_value()
+{
+	return reinterpret_cast<void*>(static_cast<std::intptr_t>(-1));
+}
+
+/// Maps the whole of `path` for reading; `mapping` receives the mapping handle. Returns false on failure.
+inline bool map_file(std::filesystem::path const& path, void*& mapping, const char*& data, std::size_t& size)
+{
+	void* file = CreateFileW(path.c_str(), generic_read, file_share_read, nullptr, open_existing, file_flag_sequential_scan, nullptr);
+	if (file == invalid_handle_value())
+	{
+		return false;
+	}
+
+	unsigned long high = 0;
+	const unsigned long low = GetFileSize(file, &high);
+	if (low == invalid_file_size && GetLastError() != 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	size = static_cast<std::size_t>(static_cast<std::uint64_t>(high) << 32 | low);
+	if (size == 0)
+	{
+		CloseHandle(file);
+		return true;
+	}
+
+	mapping = CreateFileMappingW(file, nullptr, page_readonly, 0, 0, nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr)
+	{
+		size = 0;
+		return false;
+	}
+
+	data = static_cast<const char*>(MapViewOfFile(mapping, file_map_read, 0, 0, 0));
+	if (data == nullptr)
+	{
+		CloseHandle(std::exchange(mapping, nullptr));
+		size = 0;
+		return false;
+	}
+
+	return true;
+}
+
+inline void unmap_file(void* mapping, const char* data) noexcept
+{
+	if (data != nullptr)
+	{
+		UnmapViewOfFile(data);
+	}
+	if (mapping != nullptr)
+	{
+		CloseHandle(mapping);
+	}
+}
+} // namespace fsm::detail::win32
+#endif
+
+namespace fsm
+{
+/**
+ * @brief A read-only view of a whole file, memory-mapped where the platform allows it.
+ *
+ * The file is never copied into the process: `view()` points straight at the
+ * mapping, so it can be handed to `lexer::change_source` and every token lexeme
+ * stays valid for as long as the `mapped_source` lives. On POSIX the mapping is
+ * advised as sequential; platforms without mmap fall back to reading the file.
+ */
+class mapped_source
+{
+public:
+	explicit mapped_source(std::filesystem::path const& path)
+	{
+		map(path);
+	}
+
+	mapped_source(mapped_source&& other) noexcept
+		: m_data{ std::exchange(other.m_data, nullptr) }
+		, m_size{ std::exchange(other.m_size, 0) }
+		, m_fallback{ std::move(other.m_fallback) }
+#if defined(_WIN32)
+		, m_mapping{ std::exchange(other.m_mapping, nullptr) }
+#endif
+	{
+		if (!m_fallback.empty())
+		{
+			m_data = m_fallback.data();
+		}
+	}
+
+	mapped_source& operator=(mapped_source&& other) noexcept
+	{
+		if (this != &other)
+		{
+			unmap();
+
+			m_data = std::exchange(other.m_data, nullptr);
+			m_size = std::exchange(other.m_size, 0);
+			m_fallback = std::move(other.m_fallback);
+#if defined(_WIN32)
+			m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+			if (!m_fallback.empty())
+			{
+				m_data = m_fallback.data();
+			}
+		}
+
+		return *this;
+	}
+
+	mapped_source(mapped_source const&) = delete;
+	mapped_source& operator=(mapped_source const&) = delete;
+
+	~mapped_source()
+	{
+		unmap();
+	}
+
+	[[nodiscard]] std::string_view view() const
+	{
+		return { m_data, m_size };
+	}
+
+	[[nodiscard]] const char* data() const
+	{
+		return m_data;
+	}
+
+	[[nodiscard]] std::size_t size() const
+	{
+		return m_size;
+	}
+
+	[[nodiscard]] bool empty() const
+	{
+		return m_size == 0;
+	}
+
+	operator std::string_view() const
+	{
+		return view();
+	}
+
+	/// An input stream over the mapping for the `std::istream` based loaders.
+	[[nodiscard]] std::ispanstream stream() const
+	{
+		return std::ispanstream(std::span<const char>(m_data, m_size));
+	}
+
+private:
+	const char* m_data = nullptr;
+	std::size_t m_size = 0;
+	std::string m_fallback;
+#if defined(_WIN32)
+	void* m_mapping = nullptr;
+#endif
+
+	[[noreturn]] static void fail(std::filesystem::path const& path)
+	{
+		throw std::runtime_error("Could not map file: " + path.string());
+	}
+
+	void map(std::filesystem::path const& path)
+	{
+#if defined(FSM_MAPPED_SOURCE_POSIX)
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			fail(path);
+		}
+
+		struct stat info{};
+		if (::fstat(fd, &info) != 0)
+		{
+			::close(fd);
+			fail(path);
+		}
+
+		m_size = static_cast<std::size_t>(info.st_size);
+		if (m_size == 0)
+		{
+			::close(fd);
+			return;
+		}
+
+		void* address = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (address == MAP_FAILED)
+		{
+			m_size = 0;
+			fail(path);
+		}
+
+		::madvise(address, m_size, MADV_SEQUENTIAL);
+		m_data = static_cast<const char*>(address);
+#elif defined(_WIN32)
+		if (!detail::win32::map_file(path, m_mapping, m_data, m_size))
+		{
+			fail(path);
+		}
+#else
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open())
+		{
+			fail(path);
+		}
+
+		m_fallback.assign(std::istreambuf_iterator(file), std::istreambuf_iterator<char>());
+		m_data = m_fallback.data();
+		m_size = m_fallback.size();
+#endif
+	}
+
+	void unmap() noexcept
+	{
+#if defined(FSM_MAPPED_SOURCE_POSIX)
+		if (m_data != nullptr && m_fallback.empty())
+		{
+			::munmap(const_cast<char*>(m_data), m_size);
+		}
+#elif defined(_WIN32)
+		detail::win32::unmap_file(std::exchange(m_mapping, nullptr), m_data);
+#endif
+		m_fallback.clear();
+		m_data = nullptr;
+		m_size = 0;
+	}
+};
+} // namespace fsm
+
+#endif // FSM_MAPPED_SOURCE_HPP
@@ -0,0 +1,217 @@
+#ifndef FSM_PREFILTER_HPP
+#define FSM_PREFILTER_HPP
+
+#include "regex.hpp"
+
+#include <atomic>
+#include <bitset>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace fsm
+{
+struct prefilter_stats
+{
+	std::size_t hits{}; // positions handed over to the automaton
+	std::size_t misses{}; // positions (or whole inputs) ruled out without it
+	std::size_t skipped_bytes{};
+};
+
+/**
+ * @brief Cheap literal checks run before a regex automaton is started.
+ *
+ * Built from the literals extracted out of a regex syntax tree: a required
+ * prefix, a substring every match must contain, and the set of bytes a
+ * non-empty match can start with. Scanning is delegated to `memchr` and
+ * `std::string_view::find`, which are vectorized by the standard library.
+ */
+class literal_prefilter
+{
+public:
+	static constexpr auto npos = std::string_view::npos;
+
+	literal_prefilter()
+	{
+		m_first_bytes.set();
+		m_first_count = m_first_bytes.size();
+	}
+
+	explicit literal_prefilter(details::regex_literals literals)
+		: m_prefix{ std::move(literals.prefix) }
+		, m_required{ std::move(literals.required) }
+		, m_first_bytes{ literals.first_bytes }
+		, m_first_count{ literals.first_bytes.count() }
+	{
+		for (std::size_t byte = 0; m_first_count == 1 && byte < m_first_bytes.size(); ++byte)
+		{
+			if (m_first_bytes.test(byte))
+			{
+				m_first_byte = static_cast<char>(byte);
+			}
+		}
+	}
+
+	[[nodiscard]] std::string const& prefix() const { return m_prefix; }
+
+	[[nodiscard]] std::string const& required() const { return m_required; }
+
+	[[nodiscard]] bool may_start_at(const std::string_view source, const std::size_t pos) const
+	{
+		const bool possible = pos < source.size()
+			&& m_first_bytes.test(static_cast<unsigned char>(source[pos]))
+			&& source.substr(pos).starts_with(m_prefix);
+
+		if (m_count_stats)
+		{
+			(possible ? m_stats.hits : m_stats.misses).fetch_add(1, std::memory_order_relaxed);
+		}
+
+		return possible;
+	}
+
+	[[nodiscard]] bool may_occur_in(const std::string_view source, const std::size_t pos) const
+	{
+		if (m_required.empty() || source.find(m_required, pos) != npos)
+		{
+			return true;
+		}
+
+		if (m_count_stats)
+		{
+			m_stats.misses.fetch_add(1, std::memory_order_relaxed);
+			m_stats.skipped_bytes.fetch_add(pos < source.size() ? source.size() - pos : 0, std::memory_order_relaxed);
+		}
+
+		return false;
+	}
+
+	[[nodiscard]] std::size_t next_candidate(const std::string_view source, const std::size_t pos) const
+	{
+		const std::size_t candidate = find_candidate(source, pos);
+		if (!m_count_stats)
+		{
+			return candidate;
+		}
+
+		if (candidate == npos)
+		{
+			m_stats.misses.fetch_add(1, std::memory_order_relaxed);
+			m_stats.skipped_bytes.fetch_add(pos < source.size() ? source.size() - pos : 0, std::memory_order_relaxed);
+		}
+		else
+		{
+			m_stats.hits.fetch_add(1, std::memory_order_relaxed);
+			m_stats.skipped_bytes.fetch_add(candidate - pos, std::memory_order_relaxed);
+		}
+
+		return candidate;
+	}
+
+	/// Counting is off by default, so the checks write nothing to memory shared between threads.
+	literal_prefilter& with_stats(const bool enabled = true)
+	{
+		m_count_stats = enabled;
+
+		return *this;
+	}
+
+	[[nodiscard]] bool counts_stats() const { return m_count_stats; }
+
+	/// A snapshot of the counters, which threads sharing the prefilter update concurrently.
+	[[nodiscard]] prefilter_stats stats() const { return m_stats.load(); }
+
+	void reset_stats() const { m_stats.store({}); }
+
+	/// Adds counts gathered by a copy of this prefilter, e.g. one owned by a worker thread.
+	void add_stats(prefilter_stats const& stats) const
+	{
+		m_stats.hits.fetch_add(stats.hits, std::memory_order_relaxed);
+		m_stats.misses.fetch_add(stats.misses, std::memory_order_relaxed);
+		m_stats.skipped_bytes.fetch_add(stats.skipped_bytes, std::memory_order_relaxed);
+	}
+
+private:
+	std::string m_prefix;
+	std::string m_required;
+	std::bitset<256> m_first_bytes;
+	std::size_t m_first_count{};
+	char m_first_byte{};
+	bool m_count_stats{};
+
+	/// Relaxed atomic counters: a `const` prefilter can be shared between threads.
+	struct atomic_stats
+	{
+		std::atomic<std::size_t> hits{};
+		std::atomic<std::size_t> misses{};
+		std::atomic<std::size_t> skipped_bytes{};
+
+		atomic_stats() = default;
+
+		atomic_stats(atomic_stats const& other)
+		{
+			store(other.load());
+		}
+
+		atomic_stats& operator=(atomic_stats const& other)
+		{
+			store(other.load());
+			return *this;
+		}
+
+		[[nodiscard]] prefilter_stats load() const
+		{
+			return {
+				.hits = hits.load(std::memory_order_relaxed),
+				.misses = misses.load(std::memory_order_relaxed),
+				.skipped_bytes = skipped_bytes.load(std::memory_order_relaxed),
+			};
+		}
+
+		void store(prefilter_stats const& stats)
+		{
+			hits.store(stats.hits, std::memory_order_relaxed);
+			misses.store(stats.misses, std::memory_order_relaxed);
+			skipped_bytes.store(stats.skipped_bytes, std::memory_order_relaxed);
+		}
+	};
+
+	mutable atomic_stats m_stats;
+
+	[[nodiscard]] std::size_t find_candidate(const std::string_view source, const std::size_t pos) const
+	{
+		if (pos >= source.size())
+		{
+			return npos;
+		}
+
+		if (!m_prefix.empty())
+		{
+			return source.find(m_prefix, pos);
+		}
+
+		if (m_first_count == m_first_bytes.size())
+		{
+			return pos;
+		}
+
+		if (m_first_count == 1)
+		{
+			const void* found = std::memchr(source.data() + pos, m_first_byte, source.size() - pos);
+			return found ? static_cast<const char*>(found) - source.data() : npos;
+		}
+
+		for (std::size_t i = pos; i < source.size(); ++i)
+		{
+			if (m_first_bytes.test(static_cast<unsigned char>(source[i])))
+			{
+				return i;
+			}
+		}
+
+		return npos;
+	}
+};
+} // namespace fsm
+
+#endif // FSM_PREFILTER_HPP
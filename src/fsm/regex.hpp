@@ -1,14 +1,18 @@
 #ifndef REGEX_HPP
 #define REGEX_HPP
 
+#include <algorithm>
+#include <bitset>
 #include <map>
 #include <memory>
 #include <optional>
+#include <ranges>
 #include <stack>
 #include <stdexcept>
 #include <string>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "recognizer.hpp"
 
@@ -25,13 +29,16 @@ enum class token_type
 	star, // *
 	plus, // +
 	pipe, // |
-	concat // .
+	concat, // .
+	byte_set // any byte of a set, only produced by utf8_regex_parser
 };
 
 struct token
 {
 	token_type type;
 	char value;
+
+	std::bitset<256> bytes{};
 };
 
 class regex_parser
@@ -44,6 +51,11 @@ public:
 		std::optional<std::string> term;
 	};
 
+	struct byte_set
+	{
+		std::bitset<256> bytes;
+	};
+
 	struct alteration // |
 	{
 		std::unique_ptr<ast> lhs;
@@ -70,6 +82,7 @@ public:
 	{
 		std::variant<
 			symbol,
+			byte_set,
 			std::unique_ptr<alteration>,
 			std::unique_ptr<concatenation>,
 			std::unique_ptr<kleene_star>,
@@ -88,20 +101,28 @@ public:
 	[[nodiscard]]
 	static ast operator()(std::string const& regex)
 	{
-		const auto tokens = tokenize(regex);
+		return parse(tokenize(regex));
+	}
 
+protected:
+	static ast parse(std::vector<token> const& tokens)
+	{
 		const auto processed_tokens = insert_concatenation(tokens);
 
 		const auto postfix = infix_to_postfix(processed_tokens);
 
 		std::stack<std::unique_ptr<ast>> stack;
 
-		for (const auto& [type, value] : postfix)
+		for (const auto& [type, value, bytes] : postfix)
 		{
 			if (type == token_type::literal)
 			{
 				stack.emplace(std::make_unique<ast>(symbol{ std::string(1, value) }));
 			}
+			else if (type == token_type::byte_set)
+			{
+				stack.emplace(std::make_unique<ast>(byte_set{ bytes }));
+			}
 			else if (type == token_type::etranslate)
 			{
 				stack.emplace(std::make_unique<ast>(symbol{ std::nullopt }));
@@ -160,6 +181,23 @@ public:
 		return std::move(*stack.top());
 	}
 
+	static char unescape(const char next)
+	{
+		switch (next)
+		{
+		case 'n':
+			return '\n';
+		case 'r':
+			return '\r';
+		case 't':
+			return '\t';
+		case '0':
+			return '0';
+		default:
+			return next;
+		}
+	}
+
 private:
 	static std::vector<token> tokenize(const std::string& input)
 	{
@@ -172,29 +210,8 @@ private:
 				{
 					throw std::runtime_error("Trailing backslash in regex");
 				}
-				const char next = input[++i];
-				char literal_value = next;
 
-				switch (next)
-				{
-				case 'n':
-					literal_value = '\n';
-					break;
-				case 'r':
-					literal_value = '\r';
-					break;
-				case 't':
-					literal_value = '\t';
-					break;
-				case '0':
-					literal_value = '0';
-					break;
-				default:
-					literal_value = next;
-					break;
-				}
-
-				tokens.push_back({ token_type::literal, literal_value });
+				tokens.push_back({ token_type::literal, unescape(input[++i]) });
 			}
 			else if (ch == '(')
 			{
@@ -237,11 +254,13 @@ private:
 				const auto& next = tokens[i + 1];
 
 				const bool curr_can_concat = (curr.type == token_type::literal
+					|| curr.type == token_type::byte_set
 					|| curr.type == token_type::rparen
 					|| curr.type == token_type::star
 					|| curr.type == token_type::plus);
 
 				const bool next_can_concat = (next.type == token_type::literal
+					|| next.type == token_type::byte_set
 					|| next.type == token_type::lparen);
 
 				if (curr_can_concat && next_can_concat)
@@ -270,6 +289,7 @@ private:
 			switch (tok.type)
 			{
 			case token_type::literal:
+			case token_type::byte_set:
 				postfix.push_back(tok);
 				break;
 
@@ -312,6 +332,355 @@ private:
 	}
 };
 
+/**
+ * @brief Same syntax as `regex_parser`, read as UTF-8, plus `[...]` and `[^...]` code point classes.
+ *
+ * The tree is still made of bytes, so the automata scan bytes: a multi-byte
+ * literal becomes a group of its bytes and a class becomes an alternation of
+ * UTF-8 byte sequences, split so that each sequence is a product of byte sets.
+ * Negated classes exclude surrogates.
+ */
+class utf8_regex_parser : public regex_parser
+{
+public:
+	using output_type = ast;
+
+	[[nodiscard]]
+	static ast operator()(std::string const& regex)
+	{
+		return parse(tokenize(regex));
+	}
+
+private:
+	static constexpr char32_t max_code_point = 0x10FFFF;
+	static constexpr char32_t before_surrogates = 0xD7FF;
+	static constexpr char32_t after_surrogates = 0xE000;
+
+	struct code_point_range
+	{
+		char32_t first{};
+		char32_t last{};
+	};
+
+	struct byte_range
+	{
+		unsigned char first{};
+		unsigned char last{};
+	};
+
+	static std::vector<token> tokenize(const std::string& input)
+	{
+		std::vector<token> tokens;
+		for (std::size_t i = 0; i < input.length();)
+		{
+			const char ch = input[i];
+			if (ch == '[')
+			{
+				i = read_class(input, i + 1, tokens);
+			}
+			else if (ch == '\\')
+			{
+				append_code_point(tokens, read_escaped(input, i));
+			}
+			else if (ch == '(' || ch == ')' || ch == '*' || ch == '+' || ch == '|')
+			{
+				const auto type = ch == '(' ? token_type::lparen
+					: ch == ')'             ? token_type::rparen
+					: ch == '*'             ? token_type::star
+					: ch == '+'             ? token_type::plus
+											: token_type::pipe;
+				tokens.push_back({ type, ch });
+				++i;
+			}
+			else
+			{
+				append_code_point(tokens, decode(input, i));
+			}
+		}
+
+		return tokens;
+	}
+
+	// Reads a code point at `pos`, or the character after it when it is a backslash.
+	static char32_t read_escaped(const std::string& input, std::size_t& pos)
+	{
+		if (input[pos] != '\\')
+		{
+			return decode(input, pos);
+		}
+
+		if (++pos >= input.length())
+		{
+			throw std::runtime_error("Trailing backslash in regex");
+		}
+
+		const auto unescaped = static_cast<unsigned char>(unescape(input[pos]));
+		if (unescaped < 0x80)
+		{
+			++pos;
+			return unescaped;
+		}
+
+		return decode(input, pos);
+	}
+
+	static std::size_t read_class(const std::string& input, std::size_t pos, std::vector<token>& tokens)
+	{
+		const bool negated = pos < input.length() && input[pos] == '^';
+		if (negated)
+		{
+			++pos;
+		}
+
+		std::vector<code_point_range> ranges;
+		while (pos < input.length() && input[pos] != ']')
+		{
+			const char32_t first = read_escaped(input, pos);
+			char32_t last = first;
+			if (pos + 1 < input.length() && input[pos] == '-' && input[pos + 1] != ']')
+			{
+				++pos;
+				last = read_escaped(input, pos);
+				if (last < first)
+				{
+					throw std::runtime_error("Invalid range in regex character class");
+				}
+			}
+			ranges.push_back({ first, last });
+		}
+
+		if (pos >= input.length())
+		{
+			throw std::runtime_error("Unterminated character class in regex");
+		}
+
+		ranges = normalize(std::move(ranges), negated);
+		if (ranges.empty())
+		{
+			throw std::runtime_error("Empty character class in regex");
+		}
+
+		std::vector<std::vector<byte_range>> sequences;
+		for (auto const& range : ranges)
+		{
+			split(range.first, range.last, sequences);
+		}
+		append_sequences(tokens, sequences);
+
+		return pos + 1;
+	}
+
+	// Sorts and merges the ranges, complements them if asked and cuts out the surrogates.
+	static std::vector<code_point_range> normalize(std::vector<code_point_range> ranges, const bool negated)
+	{
+		std::ranges::sort(ranges, {}, &code_point_range::first);
+
+		std::vector<code_point_range> merged;
+		for (auto const& range : ranges)
+		{
+			if (!merged.empty() && range.first <= merged.back().last + 1)
+			{
+				merged.back().last = std::max(merged.back().last, range.last);
+			}
+			else
+			{
+				merged.push_back(range);
+			}
+		}
+
+		if (negated)
+		{
+			std::vector<code_point_range> complement;
+			char32_t next = 0;
+			for (auto const& range : merged)
+			{
+				if (range.first > next)
+				{
+					complement.push_back({ next, range.first - 1 });
+				}
+				next = range.last + 1;
+			}
+			if (next <= max_code_point)
+			{
+				complement.push_back({ next, max_code_point });
+			}
+			merged = std::move(complement);
+		}
+
+		std::vector<code_point_range> result;
+		for (auto const& range : merged)
+		{
+			if (range.first <= before_surrogates)
+			{
+				result.push_back({ range.first, std::min(range.last, before_surrogates) });
+			}
+			if (range.last >= after_surrogates)
+			{
+				result.push_back({ std::max(range.first, after_surrogates), range.last });
+			}
+		}
+
+		return result;
+	}
+
+	// Splits [first, last] until every piece encodes as a product of byte ranges.
+	static void split(const char32_t first, const char32_t last, std::vector<std::vector<byte_range>>& out)
+	{
+		for (const char32_t bound : { char32_t{ 0x7F }, char32_t{ 0x7FF }, char32_t{ 0xFFFF } })
+		{
+			if (first <= bound && last > bound)
+			{
+				split(first, bound, out);
+				split(bound + 1, last, out);
+				return;
+			}
+		}
+
+		const std::string lo = encode(first);
+		for (std::size_t i = 1; i < lo.size(); ++i)
+		{
+			const char32_t mask = (char32_t{ 1 } << (6 * i)) - 1;
+			if ((first & ~mask) != (last & ~mask))
+			{
+				if ((first & mask) != 0)
+				{
+					split(first, first | mask, out);
+					split((first | mask) + 1, last, out);
+					return;
+				}
+				if ((last & mask) != mask)
+				{
+					split(first, (last & ~mask) - 1, out);
+					split(last & ~mask, last, out);
+					return;
+				}
+			}
+		}
+
+		const std::string hi = encode(last);
+		auto& sequence = out.emplace_back();
+		for (std::size_t i = 0; i < lo.size(); ++i)
+		{
+			sequence.push_back({ static_cast<unsigned char>(lo[i]), static_cast<unsigned char>(hi[i]) });
+		}
+	}
+
+	static void append_code_point(std::vector<token>& tokens, const char32_t code_point)
+	{
+		const std::string bytes = encode(code_point);
+		if (bytes.size() == 1)
+		{
+			tokens.push_back({ token_type::literal, bytes[0] });
+			return;
+		}
+
+		tokens.push_back({ token_type::lparen, '(' });
+		for (const char byte : bytes)
+		{
+			tokens.push_back({ token_type::literal, byte });
+		}
+		tokens.push_back({ token_type::rparen, ')' });
+	}
+
+	static void append_byte_range(std::vector<token>& tokens, const byte_range range)
+	{
+		if (range.first == range.last)
+		{
+			tokens.push_back({ token_type::literal, static_cast<char>(range.first) });
+			return;
+		}
+
+		token set{ token_type::byte_set, '.' };
+		for (unsigned byte = range.first; byte <= range.last; ++byte)
+		{
+			set.bytes.set(byte);
+		}
+		tokens.push_back(set);
+	}
+
+	static void append_sequences(std::vector<token>& tokens, std::vector<std::vector<byte_range>> const& sequences)
+	{
+		tokens.push_back({ token_type::lparen, '(' });
+		for (std::size_t i = 0; i < sequences.size(); ++i)
+		{
+			if (i != 0)
+			{
+				tokens.push_back({ token_type::pipe, '|' });
+			}
+
+			tokens.push_back({ token_type::lparen, '(' });
+			for (auto const& range : sequences[i])
+			{
+				append_byte_range(tokens, range);
+			}
+			tokens.push_back({ token_type::rparen, ')' });
+		}
+		tokens.push_back({ token_type::rparen, ')' });
+	}
+
+	static char32_t decode(const std::string& input, std::size_t& pos)
+	{
+		const auto lead = static_cast<unsigned char>(input[pos]);
+		const std::size_t length = lead < 0x80 ? 1
+			: (lead & 0xE0) == 0xC0            ? 2
+			: (lead & 0xF0) == 0xE0            ? 3
+			: (lead & 0xF8) == 0xF0            ? 4
+											   : 0;
+		if (length == 0 || pos + length > input.length())
+		{
+			throw std::runtime_error("Invalid UTF-8 in regex");
+		}
+
+		char32_t code_point = length == 1 ? lead : lead & (0x7F >> length);
+		for (std::size_t i = 1; i < length; ++i)
+		{
+			const auto byte = static_cast<unsigned char>(input[pos + i]);
+			if ((byte & 0xC0) != 0x80)
+			{
+				throw std::runtime_error("Invalid UTF-8 in regex");
+			}
+			code_point = (code_point << 6) | (byte & 0x3F);
+		}
+
+		if (code_point > max_code_point || encode(code_point).size() != length)
+		{
+			throw std::runtime_error("Invalid UTF-8 in regex");
+		}
+
+		pos += length;
+		return code_point;
+	}
+
+	static std::string encode(const char32_t code_point)
+	{
+		std::string bytes;
+		if (code_point < 0x80)
+		{
+			bytes += static_cast<char>(code_point);
+		}
+		else if (code_point < 0x800)
+		{
+			bytes += static_cast<char>(0xC0 | (code_point >> 6));
+			bytes += static_cast<char>(0x80 | (code_point & 0x3F));
+		}
+		else if (code_point < 0x10000)
+		{
+			bytes += static_cast<char>(0xE0 | (code_point >> 12));
+			bytes += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+			bytes += static_cast<char>(0x80 | (code_point & 0x3F));
+		}
+		else
+		{
+			bytes += static_cast<char>(0xF0 | (code_point >> 18));
+			bytes += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+			bytes += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+			bytes += static_cast<char>(0x80 | (code_point & 0x3F));
+		}
+
+		return bytes;
+	}
+};
+
 class regex_builder
 {
 public:
@@ -325,6 +694,23 @@ public:
 		return create_base_nfa(sym.term);
 	}
 
+	recognizer::state_type operator()(regex_parser::byte_set const& set)
+	{
+		auto nfa = create_base_nfa(std::nullopt);
+		const auto final = *nfa.final_state_ids.begin();
+		nfa.transitions.clear();
+
+		for (std::size_t byte = 0; byte < set.bytes.size(); ++byte)
+		{
+			if (set.bytes.test(byte))
+			{
+				nfa.transitions.emplace(std::make_pair(nfa.initial_state_id, std::string(1, static_cast<char>(byte))), final);
+			}
+		}
+
+		return nfa;
+	}
+
 	recognizer::state_type operator()(std::unique_ptr<regex_parser::alteration> const& node)
 	{
 		return op_alternate(visit_child(node->lhs), visit_child(node->rhs));
@@ -479,6 +865,172 @@ private:
 
 	size_t m_state_counter = 0;
 };
+
+struct regex_literals
+{
+	std::string prefix; // every match starts with it
+	std::string required; // every match contains it
+	std::bitset<256> first_bytes; // bytes a non-empty match can start with
+	bool nullable{};
+};
+
+class literal_extractor
+{
+	struct literal_info
+	{
+		std::optional<std::string> exact;
+		std::string prefix;
+		std::string suffix;
+		std::string required;
+		std::bitset<256> first_bytes;
+		bool nullable{};
+	};
+
+public:
+	regex_literals operator()(regex_parser::output_type const& state) const
+	{
+		auto info = visit_child(state);
+
+		return regex_literals{
+			std::move(info.prefix),
+			std::move(info.required),
+			info.first_bytes,
+			info.nullable
+		};
+	}
+
+	literal_info operator()(regex_parser::symbol const& sym) const
+	{
+		literal_info info;
+		if (!sym.term.has_value() || sym.term->empty())
+		{
+			info.exact = "";
+			info.nullable = true;
+			return info;
+		}
+
+		info.exact = *sym.term;
+		info.prefix = *sym.term;
+		info.suffix = *sym.term;
+		info.required = *sym.term;
+		info.first_bytes.set(static_cast<unsigned char>(sym.term->front()));
+
+		return info;
+	}
+
+	literal_info operator()(regex_parser::byte_set const& set) const
+	{
+		if (set.bytes.count() == 1)
+		{
+			for (std::size_t byte = 0; byte < set.bytes.size(); ++byte)
+			{
+				if (set.bytes.test(byte))
+				{
+					return (*this)(regex_parser::symbol{ std::string(1, static_cast<char>(byte)) });
+				}
+			}
+		}
+
+		literal_info info;
+		info.first_bytes = set.bytes;
+
+		return info;
+	}
+
+	literal_info operator()(std::unique_ptr<regex_parser::alteration> const& node) const
+	{
+		auto lhs = visit_child(node->lhs);
+		auto rhs = visit_child(node->rhs);
+
+		literal_info info;
+		if (lhs.exact && rhs.exact && *lhs.exact == *rhs.exact)
+		{
+			info.exact = lhs.exact;
+		}
+		info.prefix = common_prefix(lhs.prefix, rhs.prefix);
+		info.suffix = common_suffix(lhs.suffix, rhs.suffix);
+		info.required = lhs.required == rhs.required
+			? lhs.required
+			: longest(info.prefix, info.suffix);
+		info.first_bytes = lhs.first_bytes | rhs.first_bytes;
+		info.nullable = lhs.nullable || rhs.nullable;
+
+		return info;
+	}
+
+	literal_info operator()(std::unique_ptr<regex_parser::concatenation> const& node) const
+	{
+		auto lhs = visit_child(node->lhs);
+		auto rhs = visit_child(node->rhs);
+
+		literal_info info;
+		if (lhs.exact && rhs.exact)
+		{
+			info.exact = *lhs.exact + *rhs.exact;
+		}
+		info.prefix = lhs.exact ? *lhs.exact + rhs.prefix : lhs.prefix;
+		info.suffix = rhs.exact ? lhs.suffix + *rhs.exact : rhs.suffix;
+		info.required = longest(longest(lhs.required, rhs.required), lhs.suffix + rhs.prefix);
+		info.first_bytes = lhs.nullable ? lhs.first_bytes | rhs.first_bytes : lhs.first_bytes;
+		info.nullable = lhs.nullable && rhs.nullable;
+
+		return info;
+	}
+
+	literal_info operator()(std::unique_ptr<regex_parser::kleene_star> const& node) const
+	{
+		const auto child = visit_child(node->child);
+
+		literal_info info;
+		if (child.exact && child.exact->empty())
+		{
+			info.exact = "";
+		}
+		info.first_bytes = child.first_bytes;
+		info.nullable = true;
+
+		return info;
+	}
+
+	literal_info operator()(std::unique_ptr<regex_parser::kleene_plus> const& node) const
+	{
+		auto info = visit_child(node->child);
+		if (info.exact && !info.exact->empty())
+		{
+			info.exact.reset();
+		}
+
+		return info;
+	}
+
+private:
+	literal_info visit_child(regex_parser::output_type const& child_node) const
+	{
+		return std::visit(*this, child_node.node);
+	}
+
+	literal_info visit_child(std::unique_ptr<regex_parser::ast> const& child_node) const
+	{
+		return std::visit(*this, child_node->node);
+	}
+
+	static std::string common_prefix(std::string const& a, std::string const& b)
+	{
+		const auto [it, _] = std::ranges::mismatch(a, b);
+		return { a.begin(), it };
+	}
+
+	static std::string common_suffix(std::string const& a, std::string const& b)
+	{
+		const auto [it, _] = std::ranges::mismatch(a | std::views::reverse, b | std::views::reverse);
+		return { it.base(), a.end() };
+	}
+
+	static std::string longest(std::string const& a, std::string const& b)
+	{
+		return b.size() > a.size() ? b : a;
+	}
+};
 } // namespace details
 
 template <typename T_Parser, typename T_Builder>
@@ -502,6 +1054,11 @@ public:
 		}
 	}
 
+	[[nodiscard]] typename T_Parser::output_type const& syntax_tree() const
+	{
+		return m_parser_state;
+	}
+
 	recognizer compile()
 	{
 		if (m_is_compiled)
@@ -523,6 +1080,8 @@ private:
 };
 
 using regex = base_regex<details::regex_parser, details::regex_builder>;
+/// Patterns and input are UTF-8; lexers matching with it count columns in code points unless `with_column_unit` says otherwise.
+using utf8_regex = base_regex<details::utf8_regex_parser, details::regex_builder>;
 } // namespace fsm
 
 #endif // REGEX_HPP
@@ -0,0 +1,225 @@
+#ifndef FSM_REGEX_SET_HPP
+#define FSM_REGEX_SET_HPP
+
+#include "byte_dfa.hpp"
+#include "regex.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fsm
+{
+class pattern_set
+{
+public:
+	pattern_set() = default;
+
+	explicit pattern_set(const std::size_t size)
+		: m_size{ size }
+		, m_words((size + 63) / 64)
+	{
+	}
+
+	void set(const std::size_t id)
+	{
+		m_words[id / 64] |= std::uint64_t{ 1 } << (id % 64);
+	}
+
+	[[nodiscard]] bool test(const std::size_t id) const
+	{
+		return (m_words[id / 64] >> (id % 64)) & 1;
+	}
+
+	[[nodiscard]] std::size_t size() const
+	{
+		return m_size;
+	}
+
+	[[nodiscard]] std::size_t count() const
+	{
+		std::size_t result = 0;
+		for (const auto word : m_words)
+		{
+			result += std::popcount(word);
+		}
+
+		return result;
+	}
+
+	[[nodiscard]] bool none() const
+	{
+		return count() == 0;
+	}
+
+	[[nodiscard]] std::vector<std::size_t> ids() const
+	{
+		std::vector<std::size_t> result;
+		for (std::size_t id = 0; id < m_size; ++id)
+		{
+			if (test(id))
+			{
+				result.push_back(id);
+			}
+		}
+
+		return result;
+	}
+
+	pattern_set& operator|=(pattern_set const& other)
+	{
+		for (std::size_t i = 0; i < m_words.size() && i < other.m_words.size(); ++i)
+		{
+			m_words[i] |= other.m_words[i];
+		}
+
+		return *this;
+	}
+
+	bool operator==(pattern_set const& other) const = default;
+
+private:
+	std::size_t m_size{};
+	std::vector<std::uint64_t> m_words;
+};
+
+/**
+ * @brief Matches an input against many regular expressions in a single pass.
+ *
+ * All patterns are compiled into one byte-level DFA whose accepting states
+ * carry the set of pattern ids that accept there. In `whole_input` mode a
+ * pattern matches when it recognizes the entire input (like `recognize`); in
+ * `anywhere` mode it matches when it recognizes some substring of it.
+ */
+class regex_set
+{
+public:
+	enum class match_mode
+	{
+		whole_input,
+		anywhere
+	};
+
+	explicit regex_set(std::vector<std::string> const& patterns, const match_mode mode = match_mode::whole_input)
+		: m_size{ patterns.size() }
+		, m_mode{ mode }
+	{
+		const std::string start = "set_start";
+
+		recognizer_state nfa;
+		nfa.initial_state_id = start;
+		nfa.state_ids.insert(start);
+
+		details::regex_builder builder;
+		details::byte_dfa_compiler::final_tags_type final_tags;
+
+		for (std::size_t id = 0; id < patterns.size(); ++id)
+		{
+			const auto fragment = builder(details::regex_parser{}(patterns[id]));
+
+			nfa.state_ids.insert(fragment.state_ids.begin(), fragment.state_ids.end());
+			nfa.transitions.insert(fragment.transitions.begin(), fragment.transitions.end());
+			nfa.transitions.emplace(std::make_pair(start, std::nullopt), fragment.initial_state_id);
+
+			for (auto const& final_id : fragment.final_state_ids)
+			{
+				nfa.final_state_ids.insert(final_id);
+				final_tags.emplace(final_id, static_cast<std::uint32_t>(id));
+			}
+		}
+
+		if (mode == match_mode::anywhere)
+		{
+			for (int byte = 0; byte < 256; ++byte)
+			{
+				nfa.transitions.emplace(std::make_pair(start, std::string(1, static_cast<char>(byte))), start);
+			}
+		}
+
+		std::map<std::vector<std::uint32_t>, byte_dfa::tag_type> tag_of_set;
+		m_dfa = details::byte_dfa_compiler{}(nfa, final_tags, [&](std::vector<std::uint32_t> const& ids) {
+			auto [it, inserted] = tag_of_set.try_emplace(ids, static_cast<byte_dfa::tag_type>(m_accept_sets.size() + 1));
+			if (inserted)
+			{
+				pattern_set accepted(m_size);
+				for (const auto id : ids)
+				{
+					accepted.set(id);
+				}
+				m_accept_sets.push_back(std::move(accepted));
+			}
+			return it->second;
+		});
+	}
+
+	[[nodiscard]] std::size_t size() const
+	{
+		return m_size;
+	}
+
+	[[nodiscard]] match_mode mode() const
+	{
+		return m_mode;
+	}
+
+	[[nodiscard]] byte_dfa const& dfa() const
+	{
+		return m_dfa;
+	}
+
+	[[nodiscard]] pattern_set matches(const std::string_view input) const
+	{
+		pattern_set result(m_size);
+		auto state = m_dfa.start_state;
+
+		if (m_mode == match_mode::whole_input)
+		{
+			for (const char c : input)
+			{
+				state = m_dfa.next(state, static_cast<unsigned char>(c));
+				if (state == byte_dfa::dead_state)
+				{
+					return result;
+				}
+			}
+
+			if (const auto tag = m_dfa.accept_tag(state); tag != byte_dfa::no_tag)
+			{
+				result |= m_accept_sets[tag - 1];
+			}
+
+			return result;
+		}
+
+		auto last_tag = m_dfa.accept_tag(state);
+		if (last_tag != byte_dfa::no_tag)
+		{
+			result |= m_accept_sets[last_tag - 1];
+		}
+
+		for (const char c : input)
+		{
+			state = m_dfa.next(state, static_cast<unsigned char>(c));
+			if (const auto tag = m_dfa.accept_tag(state); tag != byte_dfa::no_tag && tag != last_tag)
+			{
+				result |= m_accept_sets[tag - 1];
+				last_tag = tag;
+			}
+		}
+
+		return result;
+	}
+
+private:
+	std::size_t m_size{};
+	match_mode m_mode{};
+
+	byte_dfa m_dfa;
+	std::vector<pattern_set> m_accept_sets;
+};
+} // namespace fsm
+
+#endif // FSM_REGEX_SET_HPP
@@ -0,0 +1,307 @@
+#ifndef FSM_SCANNER_GENERATOR_HPP
+#define FSM_SCANNER_GENERATOR_HPP
+
+#include "lexer.hpp"
+
+#include <cctype>
+#include <map>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fsm
+{
+struct scanner_rule
+{
+	std::string pattern;
+	std::string token_type;
+
+	bool skip{};
+};
+
+struct scanner_options
+{
+	std::string class_name = "scanner";
+	std::string namespace_name = "generated";
+	// Derived from the namespace and class name when empty.
+	std::string include_guard;
+};
+
+namespace details
+{
+class scanner_writer
+{
+public:
+	scanner_writer(std::ostream& out, std::vector<scanner_rule> const& rules, scanner_options const& options)
+		: m_out{ out }
+		, m_rules{ rules }
+		, m_options{ options }
+	{
+		for (auto const& rule : m_rules)
+		{
+			if (!is_identifier(rule.token_type))
+			{
+				throw std::invalid_argument("Token type '" + rule.token_type + "' is not a valid C++ identifier");
+			}
+
+			if (std::ranges::find(m_token_types, rule.token_type) == m_token_types.end())
+			{
+				m_token_types.push_back(rule.token_type);
+			}
+		}
+
+		std::vector<combined_dfa_matcher> matchers;
+		for (auto const& rule : m_rules)
+		{
+			matchers.push_back(combined_dfa_matcher::compile(rule.pattern));
+		}
+
+		m_engine = combined_dfa_matcher::engine(matchers);
+		m_dfa = m_engine.dfa();
+
+		m_include_guard = m_options.include_guard;
+		if (m_include_guard.empty())
+		{
+			for (const char c : m_options.namespace_name + "_" + m_options.class_name + "_HPP")
+			{
+				const auto byte = static_cast<unsigned char>(c);
+				m_include_guard += std::isalnum(byte) || c == '_' ? static_cast<char>(std::toupper(byte)) : '_';
+			}
+		}
+	}
+
+	void write()
+	{
+		write_prologue();
+		write_types();
+		write_class_head();
+		write_match_function();
+		write_class_tail();
+	}
+
+private:
+	std::ostream& m_out;
+	std::vector<scanner_rule> const& m_rules;
+	scanner_options const& m_options;
+
+	std::vector<std::string> m_token_types;
+	std::string m_include_guard;
+	combined_dfa_matcher::engine m_engine;
+	byte_dfa_view m_dfa;
+
+	static bool is_identifier(std::string const& name)
+	{
+		const auto head = [](const char c) { return c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); };
+		const auto tail = [&](const char c) { return head(c) || (c >= '0' && c <= '9'); };
+
+		return !name.empty() && head(name.front()) && std::ranges::all_of(name, tail);
+	}
+
+	void write_prologue()
+	{
+		m_out << "// Generated by fsm::generate_scanner. Do not edit.\n"
+			  << "#ifndef " << m_include_guard << "\n"
+			  << "#define " << m_include_guard << "\n\n"
+			  << "#include <cstddef>\n"
+			  << "#include <expected>\n"
+			  << "#include <optional>\n"
+			  << "#include <string_view>\n"
+			  << "#include <vector>\n\n"
+			  << "namespace " << m_options.namespace_name << "\n{\n";
+	}
+
+	void write_types()
+	{
+		m_out << "enum class token_type\n{\n";
+		for (auto const& name : m_token_types)
+		{
+			m_out << "\t" << name << ",\n";
+		}
+		m_out << "};\n\n";
+
+		m_out << "inline constexpr std::string_view to_string(const token_type type)\n{\n"
+			  << "\tswitch (type)\n\t{\n";
+		for (auto const& name : m_token_types)
+		{
+			m_out << "\tcase token_type::" << name << ":\n\t\treturn \"" << name << "\";\n";
+		}
+		m_out << "\t}\n\n\treturn {};\n}\n\n";
+
+		m_out << "struct token\n{\n"
+			  << "\ttoken_type type;\n"
+			  << "\tstd::string_view lexeme;\n\n"
+			  << "\tstd::size_t line{};\n"
+			  << "\tstd::size_t column{};\n"
+			  << "\tstd::size_t offset{};\n"
+			  << "\tstd::size_t length{};\n"
+			  << "};\n\n"
+			  << "struct lexer_error\n{\n"
+			  << "\tstd::size_t line{};\n"
+			  << "\tstd::size_t column{};\n"
+			  << "\tstd::size_t offset{};\n\n"
+			  << "\tchar unexpected_char{};\n"
+			  << "};\n\n";
+	}
+
+	void write_class_head()
+	{
+		const auto& name = m_options.class_name;
+
+		m_out << "class " << name << "\n{\n"
+			  << "public:\n"
+			  << "\tusing token_type = " << m_options.namespace_name << "::token;\n"
+			  << "\tusing result_type = std::optional<std::expected<token_type, lexer_error>>;\n\n"
+			  << "\texplicit " << name << "(const std::string_view source = {})\n"
+			  << "\t\t: m_source{ source }\n\t{\n\t}\n\n"
+			  << "\t" << name << "& change_source(const std::string_view source)\n\t{\n"
+			  << "\t\tm_source = source;\n\n"
+			  << "\t\tm_cursor = 0;\n"
+			  << "\t\tm_line = 1;\n"
+			  << "\t\tm_column = 1;\n\n"
+			  << "\t\tm_peek_buffer.reset();\n\n"
+			  << "\t\treturn *this;\n\t}\n\n"
+			  << "\tresult_type peek()\n\t{\n"
+			  << "\t\tif (!m_peek_buffer)\n\t\t{\n\t\t\tm_peek_buffer = read_next_token();\n\t\t}\n\n"
+			  << "\t\treturn m_peek_buffer;\n\t}\n\n"
+			  << "\tresult_type next()\n\t{\n"
+			  << "\t\tauto token = peek();\n\n"
+			  << "\t\tif (token)\n\t\t{\n\t\t\tm_peek_buffer.reset();\n\t\t}\n\n"
+			  << "\t\treturn token;\n\t}\n\n"
+			  << "\tstd::expected<std::vector<token_type>, lexer_error> tokenize()\n\t{\n"
+			  << "\t\tstd::vector<token_type> tokens;\n"
+			  << "\t\twhile (auto res = next())\n\t\t{\n"
+			  << "\t\t\tif (!*res)\n\t\t\t{\n\t\t\t\treturn std::unexpected(res->error());\n\t\t\t}\n"
+			  << "\t\t\ttokens.emplace_back(**res);\n\t\t}\n\n"
+			  << "\t\treturn tokens;\n\t}\n\n"
+			  << "private:\n"
+			  << "\tstruct rule_info\n\t{\n"
+			  << "\t\t" << m_options.namespace_name << "::token_type type;\n"
+			  << "\t\tbool skip;\n\t};\n\n"
+			  << "\tstatic constexpr rule_info rules[] = {\n";
+		for (auto const& rule : m_rules)
+		{
+			m_out << "\t\t{ " << m_options.namespace_name << "::token_type::" << rule.token_type << ", "
+				  << (rule.skip ? "true" : "false") << " },\n";
+		}
+		m_out << "\t};\n\n"
+			  << "\tstruct match_result\n\t{\n"
+			  << "\t\tint rule = -1;\n"
+			  << "\t\tstd::size_t length = 0;\n\t};\n\n"
+			  << "\tstd::string_view m_source;\n\n"
+			  << "\tstd::size_t m_cursor = 0;\n"
+			  << "\tstd::size_t m_line = 1;\n"
+			  << "\tstd::size_t m_column = 1;\n\n"
+			  << "\tresult_type m_peek_buffer{};\n\n"
+			  << "\tresult_type read_next_token()\n\t{\n"
+			  << "\t\twhile (m_cursor < m_source.length())\n\t\t{\n"
+			  << "\t\t\tconst auto match = longest_match(m_cursor);\n"
+			  << "\t\t\tif (match.rule < 0)\n\t\t\t{\n"
+			  << "\t\t\t\tconst auto err = std::unexpected(lexer_error{ m_line, m_column, m_cursor, m_source[m_cursor] });\n"
+			  << "\t\t\t\tadvance_cursor(1);\n\n"
+			  << "\t\t\t\treturn err;\n\t\t\t}\n\n"
+			  << "\t\t\tconst std::size_t start_line = m_line;\n"
+			  << "\t\t\tconst std::size_t start_col = m_column;\n"
+			  << "\t\t\tconst std::size_t start_offset = m_cursor;\n\n"
+			  << "\t\t\tadvance_cursor(match.length);\n\n"
+			  << "\t\t\tif (rules[match.rule].skip)\n\t\t\t{\n\t\t\t\tcontinue;\n\t\t\t}\n\n"
+			  << "\t\t\treturn token_type{\n"
+			  << "\t\t\t\trules[match.rule].type,\n"
+			  << "\t\t\t\tm_source.substr(start_offset, match.length),\n"
+			  << "\t\t\t\tstart_line,\n"
+			  << "\t\t\t\tstart_col,\n"
+			  << "\t\t\t\tstart_offset,\n"
+			  << "\t\t\t\tmatch.length\n"
+			  << "\t\t\t};\n\t\t}\n\n"
+			  << "\t\treturn std::nullopt;\n\t}\n\n"
+			  << "\tvoid advance_cursor(const std::size_t length)\n\t{\n"
+			  << "\t\tfor (std::size_t i = 0; i < length; ++i)\n\t\t{\n"
+			  << "\t\t\tif (m_source[m_cursor] == '\\n')\n\t\t\t{\n"
+			  << "\t\t\t\t++m_line;\n\t\t\t\tm_column = 1;\n\t\t\t}\n"
+			  << "\t\t\telse\n\t\t\t{\n\t\t\t\t++m_column;\n\t\t\t}\n"
+			  << "\t\t\t++m_cursor;\n\t\t}\n\t}\n\n";
+	}
+
+	// One label per DFA state; a state records its rule on entry and dispatches on the next byte.
+	void write_match_function()
+	{
+		m_out << "\tmatch_result longest_match(const std::size_t pos) const\n\t{\n"
+			  << "\t\tconst char* const begin = m_source.data() + pos;\n"
+			  << "\t\tconst char* const end = m_source.data() + m_source.size();\n"
+			  << "\t\tconst char* cursor = begin;\n"
+			  << "\t\tmatch_result result;\n\n";
+
+		const auto start = m_dfa.start_state;
+		const bool start_accepts = m_dfa.accept_tag(start) != byte_dfa::no_tag;
+		if (start == byte_dfa::dead_state)
+		{
+			m_out << "\t\treturn result;\n\t}\n";
+			return;
+		}
+		m_out << "\t\tgoto state_" << start << (start_accepts ? "_dispatch" : "") << ";\n\n";
+
+		for (byte_dfa::state_type state = 1; state < m_dfa.state_count(); ++state)
+		{
+			m_out << "\tstate_" << state << ":\n";
+			if (const auto tag = m_dfa.accept_tag(state); tag != byte_dfa::no_tag)
+			{
+				m_out << "\t\tresult = { " << tag - 1 << ", static_cast<std::size_t>(cursor - begin) };\n";
+				if (state == start)
+				{
+					m_out << "\tstate_" << state << "_dispatch:\n";
+				}
+			}
+
+			m_out << "\t\tif (cursor == end)\n\t\t{\n\t\t\treturn result;\n\t\t}\n"
+				  << "\t\tswitch (static_cast<unsigned char>(*cursor++))\n\t\t{\n";
+
+			std::map<byte_dfa::state_type, std::vector<unsigned>> bytes_by_target;
+			for (unsigned byte = 0; byte < 256; ++byte)
+			{
+				if (const auto target = m_dfa.next(state, static_cast<unsigned char>(byte)); target != byte_dfa::dead_state)
+				{
+					bytes_by_target[target].push_back(byte);
+				}
+			}
+
+			for (auto const& [target, bytes] : bytes_by_target)
+			{
+				for (const auto byte : bytes)
+				{
+					m_out << "\t\tcase " << byte << ":\n";
+				}
+				m_out << "\t\t\tgoto state_" << target << ";\n";
+			}
+
+			m_out << "\t\tdefault:\n\t\t\treturn result;\n\t\t}\n\n";
+		}
+
+		m_out << "\t}\n";
+	}
+
+	void write_class_tail()
+	{
+		m_out << "};\n"
+			  << "} // namespace " << m_options.namespace_name << "\n\n"
+			  << "#endif // " << m_include_guard << "\n";
+	}
+};
+} // namespace details
+
+/**
+ * @brief Writes a standalone header with an ahead-of-time compiled scanner for `rules`.
+ *
+ * All rules are merged into one minimized byte DFA, which is emitted as
+ * direct-coded `switch`/`goto` states in the style of re2c: no tables and no
+ * regex compilation at runtime. The generated class offers the same
+ * `next()`/`peek()`/`tokenize()`/`change_source()` interface as `fsm::lexer`,
+ * with the token types as an `enum class`. On equal match lengths the earlier
+ * rule wins, as with `combined_dfa_matcher`.
+ */
+inline void generate_scanner(std::ostream& out, std::vector<scanner_rule> const& rules, scanner_options const& options = {})
+{
+	details::scanner_writer(out, rules, options).write();
+}
+} // namespace fsm
+
+#endif // FSM_SCANNER_GENERATOR_HPP
@@ -1,8 +1,13 @@
 #ifndef FSM_SLR_HPP
 #define FSM_SLR_HPP
 
+#include "lr/ast_builder.hpp"
+#include "lr/compact_table.hpp"
+#include "lr/incremental_parser.hpp"
 #include "lr/parser.hpp"
+#include "lr/semantic_parser.hpp"
 #include "lr/table.hpp"
+#include "lr/table_io.hpp"
 #include "slr/table_builder.hpp"
 #include "slr/table_printer.hpp"
 
@@ -2,13 +2,14 @@
 #define FSM_SLR_TABLE_BUILDER_HPP
 
 #include "../cfg/cfg_algorithms.hpp"
+#include "../lr/compact_table.hpp"
+#include "../lr/item_grammar.hpp"
+#include "../lr/lr0_automaton.hpp"
 #include "../lr/lr0_item.hpp"
 #include "../lr/table.hpp"
 
 #include <algorithm>
 #include <functional>
-#include <queue>
-#include <set>
 
 namespace fsm::slr
 {
@@ -29,6 +30,10 @@ struct keep_first_t
 struct keep_last_t
 {
 };
+
+struct keep_all_t
+{
+};
 } // namespace detail
 
 namespace collision_policy
@@ -37,19 +42,20 @@ inline constexpr detail::throw_exception_t throw_exception{};
 inline constexpr detail::prefer_shift_t prefer_shift{};
 inline constexpr detail::keep_first_t keep_first{};
 inline constexpr detail::keep_last_t keep_last{};
+inline constexpr detail::keep_all_t keep_all{};
 } // namespace collision_policy
 
 template <typename T_Symbol, typename T_Compare = std::less<T_Symbol>>
 class table_builder
 {
 	using grammar_t = basic_cfg<T_Symbol, T_Compare>;
-	using item_t = lr::lr0_item<T_Symbol>;
-	using state_t = std::set<item_t>;
+	using item_t = lr::lr0_item;
 	using identity_symbol = std::type_identity_t<T_Symbol>;
 
 public:
 	using grammar_type = grammar_t;
 	using table_type = lr::table<T_Symbol, T_Compare>;
+	using compact_table_type = lr::compact_table<T_Symbol, T_Compare>;
 	using warning_callback_type = std::function<void(const std::string&)>;
 
 	explicit table_builder(const grammar_t& grammar)
@@ -91,6 +97,13 @@ public:
 		return *this;
 	}
 
+	/// Threads that expand states while building; the table does not depend on it.
+	table_builder& with_thread_count(std::size_t thread_count)
+	{
+		m_thread_count = thread_count;
+		return *this;
+	}
+
 	template <typename T_CollisionPolicy = detail::throw_exception_t>
 	table_type build(T_CollisionPolicy policy = collision_policy::throw_exception) const
 	{
@@ -103,51 +116,8 @@ public:
 		auto first_sets = algorithms::compute_first(m_grammar, m_epsilon);
 		auto follow_sets = algorithms::compute_follow(m_grammar, first_sets, m_epsilon, m_eof);
 
-		std::vector<state_t> states;
-		std::map<state_t, tbl_state_t> state_to_id;
-		std::map<std::pair<tbl_state_t, T_Symbol>, tbl_state_t> transitions;
-
-		state_t start_state = compute_closure({ { { m_aug_start, { m_grammar.start_symbol() } }, 0 } });
-		states.push_back(start_state);
-		state_to_id[start_state] = 0;
-
-		std::queue<tbl_state_t> q;
-		q.push(0);
-
-		while (!q.empty())
-		{
-			tbl_state_t current_id = q.front();
-			q.pop();
-			const state_t current_state = states[current_id];
-
-			std::set<T_Symbol, T_Compare> next_symbols;
-			for (const auto& item : current_state)
-			{
-				if (!item.is_complete() && item.next_symbol() != m_epsilon)
-				{
-					next_symbols.insert(item.next_symbol());
-				}
-			}
-
-			for (const auto& X : next_symbols)
-			{
-				state_t next_state = compute_goto(current_state, X);
-				if (next_state.empty())
-				{
-					continue;
-				}
-
-				if (!state_to_id.contains(next_state))
-				{
-					auto new_id = static_cast<tbl_state_t>(states.size());
-					states.push_back(next_state);
-					state_to_id[next_state] = new_id;
-					q.push(new_id);
-				}
-
-				transitions[{ current_id, X }] = state_to_id[next_state];
-			}
-		}
+		const lr::detail::item_grammar<T_Symbol, T_Compare> items(m_grammar, m_epsilon, m_aug_start);
+		const auto [kernels, transitions] = lr::detail::build_lr0_automaton(items, m_thread_count);
 
 		auto try_add_action = [&](tbl_state_t state_id, const T_Symbol& terminal, const action_type& new_action) {
 			const auto& existing = result.get_action(state_id, terminal);
@@ -191,17 +161,22 @@ public:
 					try_warn("[WARNING] " + msg + " -> Resolved: Keep Last.");
 
 					result.add_action(state_id, terminal, new_action);
+				},
+				[&](detail::keep_all_t) {
+					try_warn("[WARNING] " + msg + " -> Resolved: Keep All.");
+
+					result.add_conflict(state_id, terminal, new_action);
 				}
 			}(policy);
 		};
 
-		for (tbl_state_t i = 0; i < states.size(); ++i)
+		for (tbl_state_t i = 0; i < kernels.size(); ++i)
 		{
-			for (const state_t& I = states[i]; const auto& item : I)
+			for (const item_t item : items.closure(kernels[i]))
 			{
-				if (!item.is_complete())
+				if (!items.is_complete(item))
 				{ // A -> alpha . a beta (SHIFT)
-					T_Symbol a = item.next_symbol();
+					const T_Symbol& a = items.next_symbol(item);
 					if (m_grammar.is_terminal(a) && transitions.contains({ i, a }))
 					{
 						try_add_action(i, a, lr::action_shift<tbl_state_t>{ transitions.at({ i, a }) });
@@ -211,15 +186,15 @@ public:
 						result.add_goto(i, a, transitions.at({ i, a }));
 					}
 				}
-				else if (item.rule.lhs == m_aug_start)
+				else if (items.rule(item).lhs == m_aug_start)
 				{ // S' -> S . (ACCEPT)
 					try_add_action(i, m_eof, lr::action_accept{});
 				}
 				else
 				{ // A -> alpha . (REDUCE)
-					for (const auto& a : follow_sets.at(item.rule.lhs))
+					for (const auto& a : follow_sets.at(items.rule(item).lhs))
 					{
-						try_add_action(i, a, lr::action_reduce<T_Symbol>{ item.rule });
+						try_add_action(i, a, result.make_reduce(items.rule(item), m_epsilon));
 					}
 				}
 			}
@@ -228,6 +203,13 @@ public:
 		return result;
 	}
 
+	/// Same as `build`, frozen into an `lr::compact_table` for parsing.
+	template <typename T_CollisionPolicy = detail::throw_exception_t>
+	compact_table_type build_compact(T_CollisionPolicy policy = collision_policy::throw_exception) const
+	{
+		return compact_table_type(build(policy));
+	}
+
 private:
 	grammar_t m_grammar;
 
@@ -236,59 +218,7 @@ private:
 	T_Symbol m_aug_start;
 
 	warning_callback_type m_warning_callback;
-
-	state_t compute_closure(state_t I) const
-	{
-		bool changed = true;
-		while (changed)
-		{
-			changed = false;
-			std::vector<item_t> items_to_add;
-
-			for (const auto& item : I)
-			{
-				if (!item.is_complete() && m_grammar.is_non_terminal(item.next_symbol()))
-				{
-					T_Symbol B = item.next_symbol();
-					for (const auto& rule : m_grammar.rules())
-					{
-						if (rule.lhs == B)
-						{
-							std::size_t initial_dot = (rule.rhs.size() == 1 && rule.rhs[0] == m_epsilon) ? 1 : 0;
-							if (item_t new_item{ rule, initial_dot }; !I.contains(new_item))
-							{
-								items_to_add.push_back(new_item);
-							}
-						}
-					}
-				}
-			}
-
-			for (const auto& new_item : items_to_add)
-			{
-				if (I.insert(new_item).second)
-				{
-					changed = true;
-				}
-			}
-		}
-
-		return I;
-	}
-
-	state_t compute_goto(const state_t& I, const T_Symbol& X) const
-	{
-		state_t J;
-		for (const auto& item : I)
-		{
-			if (!item.is_complete() && item.next_symbol() == X)
-			{
-				J.insert({ item.rule, item.dot + 1 });
-			}
-		}
-
-		return compute_closure(J);
-	}
+	std::size_t m_thread_count = 1;
 
 	void try_warn(const std::string& msg) const
 	{
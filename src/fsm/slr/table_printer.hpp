@@ -20,13 +20,13 @@ void print_table(const lr::table<T_Symbol, T_Compare>& table, std::ostream& out
 	std::set<symbol_type> terminals;
 	std::set<symbol_type> non_terminals;
 
-	const auto to_string = [](const action_type& action) -> std::string {
+	const auto to_string = [&table](const action_type& action) -> std::string {
 		using namespace fsm::lr::actions;
 		return utility::overloaded_visitor(
 			action,
 			[](const lr::action_error&) -> std::string { return ""; },
 			[](const lr::action_accept&) -> std::string { return "accept"; },
-			[](const lr::action_reduce<symbol_type>& act) -> std::string { return "r(" + act.rule.lhs + ")"; },
+			[&table](const lr::action_reduce& act) -> std::string { return "r(" + table.rule(act.rule_index).lhs + ")"; },
 			[](const lr::action_shift<state_type>& act) -> std::string { return "s(" + std::to_string(act.target_state) + ")"; });
 	};
 
@@ -104,13 +104,13 @@ void print_table_csv(const lr::table<T_Symbol, T_Compare>& table, std::ostream&
 	std::set<symbol_type> terminals;
 	std::set<symbol_type> non_terminals;
 
-	const auto to_string = [](const action_type& action) -> std::string {
+	const auto to_string = [&table](const action_type& action) -> std::string {
 		using namespace fsm::lr::actions;
 		return utility::overloaded_visitor(
 			action,
 			[](const lr::action_error&) -> std::string { return ""; },
 			[](const lr::action_accept&) -> std::string { return "accept"; },
-			[](const lr::action_reduce<symbol_type>& act) -> std::string { return "r(" + act.rule.lhs + ")"; },
+			[&table](const lr::action_reduce& act) -> std::string { return "r(" + table.rule(act.rule_index).lhs + ")"; },
 			[](const lr::action_shift<state_type>& act) -> std::string { return "s(" + std::to_string(act.target_state) + ")"; });
 	};
 
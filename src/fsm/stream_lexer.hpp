@@ -0,0 +1,325 @@
+#ifndef FSM_STREAM_LEXER_HPP
+#define FSM_STREAM_LEXER_HPP
+
+#include "concepts.hpp"
+#include "lexer.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <istream>
+#include <span>
+#include <string>
+
+namespace fsm
+{
+template <typename T_Type>
+struct owned_token
+{
+	T_Type type;
+	std::string lexeme;
+
+	std::size_t line{};
+	std::size_t column{};
+	std::size_t offset{};
+	std::size_t length{};
+
+	owned_token() = default;
+
+	explicit owned_token(token<T_Type> const& view)
+		: type{ view.type }
+		, lexeme{ view.lexeme }
+		, line{ view.line }
+		, column{ view.column }
+		, offset{ view.offset }
+		, length{ view.length }
+	{
+	}
+};
+
+/**
+ * @brief Tokenizes input pulled in fixed-size chunks instead of one string.
+ *
+ * Only a window of the input is kept in memory. When a match runs into the
+ * end of the window while its automaton is still alive, the unread tail is
+ * carried to the front of the buffer and the next chunk is appended, so tokens
+ * straddling a chunk boundary are matched as a whole. Token offsets are
+ * absolute positions in the stream.
+ *
+ * Lexemes of `next()`/`peek()` point into the window and stay valid until the
+ * next call to either of them; use `next_owned()` to keep a token longer.
+ */
+template <typename T_TokenType, typename T_Matcher = fsm_regex_matcher>
+	requires concepts::combined_matcher<T_Matcher> || concepts::scanning_matcher<T_Matcher>
+class stream_lexer
+{
+	using token_t = token<T_TokenType>;
+
+	template <typename T>
+	using expected_value = std::expected<T, lexer_error>;
+
+public:
+	using token_type = token_t;
+	using owned_token_type = owned_token<T_TokenType>;
+	using result_type = std::optional<expected_value<token_type>>;
+	using rule = typename lexer<T_TokenType, T_Matcher>::rule;
+
+	/// Fills the span with the next bytes of input and returns their count; 0 means end of input.
+	using reader_type = std::function<std::size_t(std::span<char>)>;
+
+	static constexpr std::size_t default_chunk_size = 64 * 1024;
+	static constexpr column_unit columns = details::matcher_columns<T_Matcher>();
+
+	explicit stream_lexer(reader_type reader, const std::size_t chunk_size = default_chunk_size)
+		: stream_lexer(std::move(reader), {}, chunk_size)
+	{
+	}
+
+	stream_lexer(reader_type reader, std::vector<rule> rules, const std::size_t chunk_size = default_chunk_size)
+		: m_reader{ std::move(reader) }
+		, m_rules{ std::move(rules) }
+		, m_chunk_size{ std::max<std::size_t>(1, chunk_size) }
+	{
+	}
+
+	explicit stream_lexer(std::istream& input, const std::size_t chunk_size = default_chunk_size)
+		: stream_lexer(make_reader(input), {}, chunk_size)
+	{
+	}
+
+	stream_lexer(std::istream& input, std::vector<rule> rules, const std::size_t chunk_size = default_chunk_size)
+		: stream_lexer(make_reader(input), std::move(rules), chunk_size)
+	{
+	}
+
+	stream_lexer& add_rule(
+		std::string const& expression,
+		T_TokenType type,
+		const bool skip = false)
+	{
+		m_rules.emplace_back(type, T_Matcher::compile(expression), skip);
+
+		m_peek_buffer.reset();
+		m_engine.reset();
+
+		return *this;
+	}
+
+	result_type peek()
+	{
+		if (!m_peek_buffer)
+		{
+			m_peek_buffer = read_next_token();
+		}
+
+		return m_peek_buffer;
+	}
+
+	result_type next()
+	{
+		auto token = peek();
+
+		if (token)
+		{
+			m_peek_buffer.reset();
+		}
+
+		return token;
+	}
+
+	std::optional<expected_value<owned_token_type>> next_owned()
+	{
+		auto token = next();
+		if (!token)
+		{
+			return std::nullopt;
+		}
+
+		if (!*token)
+		{
+			return std::unexpected(token->error());
+		}
+
+		return owned_token_type{ **token };
+	}
+
+	/// Absolute offset of the first byte still held in the window.
+	[[nodiscard]] std::size_t window_offset() const
+	{
+		return m_window_offset;
+	}
+
+	[[nodiscard]] std::string_view window() const
+	{
+		return m_buffer;
+	}
+
+private:
+	struct match_result
+	{
+		rule const* matched_rule{};
+		std::size_t length{};
+		bool reached_end{};
+	};
+
+	using engine_t = typename details::matcher_engine<T_Matcher>::type;
+
+	reader_type m_reader;
+	std::vector<rule> m_rules;
+	std::optional<engine_t> m_engine;
+
+	std::size_t m_chunk_size{};
+	std::string m_buffer;
+	std::size_t m_window_offset = 0;
+	bool m_eof = false;
+
+	std::size_t m_cursor = 0;
+	std::size_t m_line = 1;
+	std::size_t m_column = 1;
+
+	result_type m_peek_buffer{};
+
+	static reader_type make_reader(std::istream& input)
+	{
+		return [&input](std::span<char> buffer) -> std::size_t {
+			input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+			return static_cast<std::size_t>(input.gcount());
+		};
+	}
+
+	// Drops the consumed part of the window and appends one more chunk.
+	bool refill()
+	{
+		if (m_eof)
+		{
+			return false;
+		}
+
+		m_buffer.erase(0, m_cursor);
+		m_window_offset += m_cursor;
+		m_cursor = 0;
+
+		const std::size_t carried = m_buffer.size();
+		m_buffer.resize(carried + m_chunk_size);
+
+		const std::size_t read = m_reader(std::span(m_buffer).subspan(carried));
+		m_buffer.resize(carried + read);
+
+		m_eof = read == 0;
+
+		return read > 0;
+	}
+
+	result_type read_next_token()
+	{
+		while (true)
+		{
+			if (m_cursor == m_buffer.size() && !refill())
+			{
+				return std::nullopt;
+			}
+
+			const auto match = find_longest_match();
+			if (match.reached_end && refill())
+			{
+				continue;
+			}
+
+			if (!match.matched_rule)
+			{
+				return make_error_and_advance();
+			}
+
+			std::size_t start_line = m_line;
+			std::size_t start_col = m_column;
+			std::size_t start_cursor = m_cursor;
+
+			advance_cursor(match.length);
+
+			if (match.matched_rule->skip)
+			{
+				continue;
+			}
+
+			return token_type{
+				match.matched_rule->type,
+				std::string_view(m_buffer).substr(start_cursor, match.length),
+				start_line,
+				start_col,
+				m_window_offset + start_cursor,
+				match.length
+			};
+		}
+	}
+
+	match_result find_longest_match()
+	{
+		const std::string_view source = m_buffer;
+
+		if constexpr (concepts::combined_matcher<T_Matcher>)
+		{
+			if (!m_engine)
+			{
+				m_engine.emplace(m_rules | std::views::transform(&rule::matcher));
+			}
+
+			const auto scan = m_engine->scan(source, m_cursor);
+			if (scan.longest)
+			{
+				return { &m_rules[scan.longest->rule_index], scan.longest->length, scan.reached_end };
+			}
+
+			return { nullptr, 0, scan.reached_end };
+		}
+		else
+		{
+			match_result best;
+
+			for (const auto& rule : m_rules)
+			{
+				const auto scan = rule.matcher.scan(source, m_cursor);
+				if (scan.length > best.length)
+				{
+					best.matched_rule = &rule;
+					best.length = scan.length;
+				}
+				best.reached_end = best.reached_end || scan.reached_end;
+			}
+
+			return best;
+		}
+	}
+
+	void advance_cursor(const size_t length)
+	{
+		for (std::size_t i = 0; i < length; ++i)
+		{
+			if (const char ch = m_buffer[m_cursor]; ch == '\n')
+			{
+				++m_line;
+				m_column = 1;
+			}
+			else if (columns == column_unit::bytes || (static_cast<unsigned char>(ch) & 0xC0) != 0x80)
+			{
+				++m_column;
+			}
+			++m_cursor;
+		}
+	}
+
+	result_type make_error_and_advance()
+	{
+		const auto err = std::unexpected(lexer_error{
+			m_line,
+			m_column,
+			m_window_offset + m_cursor,
+			m_buffer[m_cursor],
+		});
+
+		advance_cursor(1);
+
+		return err;
+	}
+};
+} // namespace fsm
+
+#endif // FSM_STREAM_LEXER_HPP
@@ -0,0 +1,111 @@
+#ifndef FSM_TOKEN_BUFFER_HPP
+#define FSM_TOKEN_BUFFER_HPP
+
+#include "line_index.hpp"
+
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace fsm
+{
+/**
+ * @brief Fixed-capacity token storage laid out as parallel arrays.
+ *
+ * Only the type, offset and length of a token are stored; the lexeme is a
+ * slice of the source and the line/column come from a `line_index`, both on
+ * demand. Memory is reserved once, so filling the buffer never reallocates,
+ * and `types()` can be passed directly to `lr::parser::parse`.
+ */
+template <typename T_TokenType>
+class token_buffer
+{
+public:
+	using token_type = T_TokenType;
+
+	explicit token_buffer(const std::size_t capacity)
+		: m_capacity{ capacity }
+	{
+		if (capacity == 0)
+		{
+			throw std::invalid_argument("token_buffer capacity must be positive");
+		}
+
+		m_types.reserve(capacity);
+		m_offsets.reserve(capacity);
+		m_lengths.reserve(capacity);
+	}
+
+	void push_back(T_TokenType type, const std::size_t offset, const std::size_t length)
+	{
+		m_types.push_back(std::move(type));
+		m_offsets.push_back(offset);
+		m_lengths.push_back(length);
+	}
+
+	void clear()
+	{
+		m_types.clear();
+		m_offsets.clear();
+		m_lengths.clear();
+	}
+
+	[[nodiscard]] std::size_t size() const
+	{
+		return m_types.size();
+	}
+
+	[[nodiscard]] std::size_t capacity() const
+	{
+		return m_capacity;
+	}
+
+	[[nodiscard]] bool empty() const
+	{
+		return m_types.empty();
+	}
+
+	[[nodiscard]] bool full() const
+	{
+		return m_types.size() >= m_capacity;
+	}
+
+	[[nodiscard]] std::span<const T_TokenType> types() const
+	{
+		return m_types;
+	}
+
+	[[nodiscard]] std::span<const std::size_t> offsets() const
+	{
+		return m_offsets;
+	}
+
+	[[nodiscard]] std::span<const std::size_t> lengths() const
+	{
+		return m_lengths;
+	}
+
+	[[nodiscard]] std::string_view lexeme(const std::size_t index, const std::string_view source) const
+	{
+		return source.substr(m_offsets[index], m_lengths[index]);
+	}
+
+	[[nodiscard]] source_position position(
+		const std::size_t index,
+		line_index const& lines,
+		const column_unit unit = column_unit::bytes) const
+	{
+		return lines.at(m_offsets[index], unit);
+	}
+
+private:
+	std::vector<T_TokenType> m_types;
+	std::vector<std::size_t> m_offsets;
+	std::vector<std::size_t> m_lengths;
+
+	std::size_t m_capacity{};
+};
+} // namespace fsm
+
+#endif // FSM_TOKEN_BUFFER_HPP
@@ -1,14 +1,27 @@
 #include <execution>
 #include <gtest/gtest.h>
 #include <stack>
+#include <thread>
 
 #include <fsm/cfg.hpp>
+#include <fsm/glr.hpp>
 #include <fsm/integer_symbol_generator.hpp>
 #include <fsm/lalr.hpp>
+#include <fsm/lexer.hpp>
+#include <fsm/lexer_cache.hpp>
+#include <fsm/lexer_spec.hpp>
 #include <fsm/ll1.hpp>
+#include <fsm/lr1.hpp>
+#include <fsm/mapped_source.hpp>
 #include <fsm/recognizer.hpp>
+#include <fsm/regex_set.hpp>
+#include <fsm/scanner_generator.hpp>
 #include <fsm/slr.hpp>
+#include <fsm/stream_lexer.hpp>
 #include <fsm/string_symbol_generator.hpp>
+#include <fsm/token_buffer.hpp>
+
+#include <lang_scanner.hpp>
 
 using namespace fsm;
 using namespace fsm::transforms;
@@ -1326,7 +1339,7 @@ TEST(SLR1TableBuilderTest, CorrectnessAndLogic)
 
 	auto act_reduce_S = table.get_action(state_3, "$");
 	ASSERT_TRUE(is_reduce(act_reduce_S));
-	auto reduce_rule_S = as_reduce(act_reduce_S).rule;
+	auto reduce_rule_S = table.rule(as_reduce(act_reduce_S).rule_index);
 	EXPECT_EQ(reduce_rule_S.lhs, "S");
 	EXPECT_EQ(reduce_rule_S.rhs.size(), 2);
 
@@ -1336,7 +1349,7 @@ TEST(SLR1TableBuilderTest, CorrectnessAndLogic)
 
 	auto act_reduce_B = table.get_action(state_4, "$");
 	ASSERT_TRUE(is_reduce(act_reduce_B));
-	auto reduce_rule_B = as_reduce(act_reduce_B).rule;
+	auto reduce_rule_B = table.rule(as_reduce(act_reduce_B).rule_index);
 	EXPECT_EQ(reduce_rule_B.lhs, "B");
 	EXPECT_EQ(reduce_rule_B.rhs[0], "b");
 }
@@ -1381,7 +1394,7 @@ TEST(SLR1TableBuilderTest, CustomSymbolType)
 
 	auto& reduce_action = table.get_action(state_after_x, eof);
 	EXPECT_TRUE(is_reduce(reduce_action));
-	EXPECT_EQ(as_reduce(reduce_action).rule.lhs.id, S.id);
+	EXPECT_EQ(table.rule(as_reduce(reduce_action).rule_index).lhs.id, S.id);
 }
 
 class SLRParserTest : public testing::Test
@@ -1424,7 +1437,7 @@ TEST_F(SLRParserTest, SuccessfulParseSequence)
 
 	auto e2 = p.next();
 	ASSERT_TRUE(events::is_reduce(*e2));
-	EXPECT_EQ(events::as_reduce(*e2).rule.lhs, "S");
+	EXPECT_EQ(table.rule(events::as_reduce(*e2).rule_index).lhs, "S");
 	EXPECT_FALSE(p.is_finished());
 
 	auto e3 = p.next();
@@ -1460,14 +1473,15 @@ TEST_F(SLRParserTest, EpsilonReductionLogic)
 
 	auto e2 = p.next();
 	ASSERT_TRUE(events::is_reduce(*e2));
-	auto rule_B = events::as_reduce(*e2).rule;
+	EXPECT_EQ(events::as_reduce(*e2).pop_count, 0);
+	auto rule_B = table.rule(events::as_reduce(*e2).rule_index);
 	EXPECT_EQ(rule_B.lhs, "B");
 	ASSERT_EQ(rule_B.rhs.size(), 1);
 	EXPECT_EQ(rule_B.rhs[0], "ε");
 
 	auto e3 = p.next();
 	ASSERT_TRUE(events::is_reduce(*e3));
-	EXPECT_EQ(events::as_reduce(*e3).rule.lhs, "S");
+	EXPECT_EQ(table.rule(events::as_reduce(*e3).rule_index).lhs, "S");
 
 	auto e4 = p.next();
 	ASSERT_TRUE(events::is_accept(*e4));
@@ -1480,7 +1494,7 @@ lr::table<char> create_mock_table()
 
 	const cfg_rule rule{ 'S', { 'a' } };
 	tbl.add_action(0, 'a', lr::action_shift<std::size_t>{ 1 });
-	tbl.add_action(1, '$', lr::action_reduce{ rule });
+	tbl.add_action(1, '$', tbl.make_reduce(rule, 'e'));
 	tbl.add_goto(0, 'S', 2);
 	tbl.add_action(2, '$', lr::action_accept{});
 
@@ -1535,6 +1549,62 @@ TEST(SlrParserTest, WhileLoopHandlesErrorsCorrectly)
 	EXPECT_FALSE(p.next().has_value());
 }
 
+TEST(LrTableIo, RoundTripKeepsRulesAndReduceActions)
+{
+	static_assert(std::is_trivially_copyable_v<lr::action_reduce>);
+	static_assert(std::is_trivially_copyable_v<lr::event_reduce>);
+
+	const auto tbl = create_mock_table();
+
+	std::stringstream buffer;
+	lr::io::save_to_binary(tbl, buffer);
+	const auto loaded = lr::io::load_from_binary<char>(buffer);
+
+	EXPECT_EQ(loaded.end_marker(), '$');
+	EXPECT_EQ(loaded.rules(), tbl.rules());
+	EXPECT_EQ(loaded.non_terminals(), tbl.non_terminals());
+
+	const auto reduce = lr::actions::as_reduce(loaded.get_action(1, '$'));
+	EXPECT_EQ(reduce, lr::actions::as_reduce(tbl.get_action(1, '$')));
+	EXPECT_EQ(reduce.pop_count, 1);
+	EXPECT_EQ(loaded.rule(reduce.rule_index).lhs, 'S');
+	EXPECT_EQ(loaded.get_goto(0, reduce), 2);
+
+	lr::parser p(loaded);
+	std::vector input = { 'a' };
+	std::vector<std::size_t> event_indices;
+	for (const auto& event : p.parse(input))
+	{
+		event_indices.push_back(event.index());
+	}
+	EXPECT_EQ(event_indices, (std::vector<std::size_t>{ 0, 1, 2 }));
+}
+
+TEST(LrTableIo, RejectsForeignAndInconsistentTables)
+{
+	std::stringstream foreign("not a table at all");
+	EXPECT_THROW(lr::io::load_from_binary<char>(foreign), std::runtime_error);
+
+	std::stringstream saved;
+	lr::io::save_to_binary(create_mock_table(), saved);
+	std::string bytes = saved.str();
+	bytes[8] = static_cast<char>(lr::io::table_format_version + 1);
+	std::stringstream newer(bytes);
+	EXPECT_THROW(lr::io::load_from_binary<char>(newer), std::runtime_error);
+
+	auto tbl = create_mock_table();
+	tbl.add_action(3, 'a', lr::action_reduce{ .rule_index = 7, .pop_count = 1, .lhs_column = 0 });
+	std::stringstream bad_rule;
+	lr::io::save_to_binary(tbl, bad_rule);
+	EXPECT_THROW(lr::io::load_from_binary<char>(bad_rule), std::runtime_error);
+
+	tbl = create_mock_table();
+	tbl.add_action(3, 'a', lr::action_reduce{ .rule_index = 0, .pop_count = 1, .lhs_column = 5 });
+	std::stringstream bad_column;
+	lr::io::save_to_binary(tbl, bad_column);
+	EXPECT_THROW(lr::io::load_from_binary<char>(bad_column), std::runtime_error);
+}
+
 // S -> a
 TEST_F(SLRParserTest, SyntaxErrorHandling)
 {
@@ -1659,8 +1729,8 @@ TEST_F(SLRCollisionPolicyTest, KeepFirstResolvesSR)
 	auto act_e = table.get_action(state_conflict, "e");
 
 	ASSERT_TRUE(is_reduce(act_e));
-	EXPECT_EQ(as_reduce(act_e).rule.lhs, "S");
-	EXPECT_EQ(as_reduce(act_e).rule.rhs.size(), 2); // Reduced S -> iS
+	EXPECT_EQ(table.rule(as_reduce(act_e).rule_index).lhs, "S");
+	EXPECT_EQ(table.rule(as_reduce(act_e).rule_index).rhs.size(), 2); // Reduced S -> iS
 }
 
 TEST_F(SLRCollisionPolicyTest, KeepLastResolvesSR)
@@ -1697,7 +1767,7 @@ TEST_F(SLRCollisionPolicyTest, PreferShiftResolvesRRAsKeepFirst)
 
 	ASSERT_TRUE(is_reduce(act_eof));
 	// A < B
-	EXPECT_EQ(as_reduce(act_eof).rule.lhs, "A");
+	EXPECT_EQ(table.rule(as_reduce(act_eof).rule_index).lhs, "A");
 }
 
 TEST_F(SLRCollisionPolicyTest, KeepLastResolvesRR)
@@ -1715,7 +1785,7 @@ TEST_F(SLRCollisionPolicyTest, KeepLastResolvesRR)
 	auto act_eof = table.get_action(state_conflict, "$");
 
 	ASSERT_TRUE(is_reduce(act_eof));
-	EXPECT_EQ(as_reduce(act_eof).rule.lhs, "B");
+	EXPECT_EQ(table.rule(as_reduce(act_eof).rule_index).lhs, "B");
 }
 
 TEST_F(SLRCollisionPolicyTest, WarningCallbackIsTriggered)
@@ -1767,7 +1837,7 @@ TEST(SLRPrinter, SuccessfullyPrintsSLRTable)
 			[](const lr::event_accept&) { std::cout << "accept" << std::endl; },
 			[](const lr::event_error<std::string>& e) { std::cout << "error: expected " << e.unexpected_token; },
 			[](const lr::event_shift<std::string>& e) { std::cout << "shift: " << e.token << std::endl; },
-			[](const lr::event_reduce<std::string>& e) { std::cout << "reduce: " << e.rule.lhs << std::endl; });
+			[&](const lr::event_reduce& e) { std::cout << "reduce: " << table.rule(e.rule_index).lhs << std::endl; });
 	}
 }
 
@@ -1949,4 +2019,1543 @@ TEST_F(LALRTableBuilderTest, MathematicalExpressionAcceptance)
 	}
 
 	EXPECT_TRUE(is_accepted);
-}
\ No newline at end of file
+}
+
+// S -> A B c
+// A -> a A | ε
+// B -> b B | ε
+// Lookaheads of the ε-rules come from FIRST of what follows them and propagate through the kernels.
+TEST_F(LALRTableBuilderTest, LookaheadsPropagateThroughEpsilonRules)
+{
+	using namespace fsm::lr::actions;
+
+	basic_cfg<std::string> g(
+		{ "S'", "S", "A", "B" }, { "a", "b", "c" },
+		{ { "S'", { "S" } },
+			{ "S", { "A", "B", "c" } },
+			{ "A", { "a", "A" } },
+			{ "A", { "ε" } },
+			{ "B", { "b", "B" } },
+			{ "B", { "ε" } } },
+		"S'");
+
+	const auto table = lalr::table_builder(g)
+						   .with_epsilon("ε")
+						   .with_end_marker("$")
+						   .with_augmented_start("S'")
+						   .build()
+						   .value();
+
+	for (const auto* terminal : { "b", "c" })
+	{
+		ASSERT_TRUE(is_reduce(table.get_action(0, terminal))) << terminal;
+		EXPECT_EQ(table.rule(as_reduce(table.get_action(0, terminal)).rule_index), (cfg_rule<std::string>{ "A", { "ε" } }));
+	}
+	EXPECT_TRUE(is_shift(table.get_action(0, "a")));
+	EXPECT_TRUE(is_error(table.get_action(0, "$")));
+
+	const auto after_a = as_shift(table.get_action(0, "a")).target_state;
+	EXPECT_TRUE(is_reduce(table.get_action(after_a, "c")));
+	EXPECT_TRUE(is_error(table.get_action(after_a, "$")));
+
+	const auto accepts = [&](std::vector<std::string> const& input) {
+		lr::parser p(table);
+		bool accepted = false;
+		for (const auto& event : p.parse(input))
+		{
+			accepted = lr::events::is_accept(event);
+		}
+		return accepted;
+	};
+	EXPECT_TRUE(accepts({ "c" }));
+	EXPECT_TRUE(accepts({ "a", "a", "b", "c" }));
+	EXPECT_TRUE(accepts({ "b", "b", "c" }));
+	EXPECT_FALSE(accepts({ "b", "a", "c" }));
+	EXPECT_FALSE(accepts({ "a", "b" }));
+}
+
+TEST(LR1TableBuilder, SplitsStatesOfLR1OnlyGrammar)
+{
+	basic_cfg<std::string> g(
+		{ "S'", "S", "E", "F" }, { "a", "b", "e" },
+		{ { "S'", { "S" } },
+			{ "S", { "a", "E", "a" } },
+			{ "S", { "b", "E", "b" } },
+			{ "S", { "a", "F", "b" } },
+			{ "S", { "b", "F", "a" } },
+			{ "E", { "e" } },
+			{ "F", { "e" } } },
+		"S'");
+
+	lr1::build_stats stats;
+	const auto table = lr1::table_builder(g)
+						   .with_epsilon("ε")
+						   .with_end_marker("$")
+						   .with_augmented_start("S'")
+						   .build(lr::collision_policy::strict, stats);
+
+	ASSERT_TRUE(table.has_value()) << table.error().front().to_string();
+	EXPECT_EQ(stats.split_states(), 1);
+	EXPECT_EQ(stats.state_count, stats.lalr_state_count + 1);
+
+	const auto accepts = [&](std::vector<std::string> const& input) {
+		lr::parser p(*table);
+		bool accepted = false;
+		for (const auto& event : p.parse(input))
+		{
+			accepted = lr::events::is_accept(event);
+		}
+		return accepted;
+	};
+	EXPECT_TRUE(accepts({ "a", "e", "a" }));
+	EXPECT_TRUE(accepts({ "a", "e", "b" }));
+	EXPECT_TRUE(accepts({ "b", "e", "a" }));
+	EXPECT_TRUE(accepts({ "b", "e", "b" }));
+	EXPECT_FALSE(accepts({ "a", "e" }));
+}
+
+TEST(LR1TableBuilder, MatchesLalrTableOfLalrGrammar)
+{
+	basic_cfg<std::string> g(
+		{ "E'", "E", "T", "F" }, { "+", "*", "(", ")", "id" },
+		{ { "E'", { "E" } },
+			{ "E", { "E", "+", "T" } },
+			{ "E", { "T" } },
+			{ "T", { "T", "*", "F" } },
+			{ "T", { "F" } },
+			{ "F", { "(", "E", ")" } },
+			{ "F", { "id" } } },
+		"E'");
+
+	lr1::build_stats stats;
+	const auto lr1_table = lr1::table_builder(g)
+							   .with_epsilon("ε")
+							   .with_end_marker("$")
+							   .with_augmented_start("E'")
+							   .build(lr::collision_policy::strict, stats)
+							   .value();
+	const auto lalr_table = lalr::table_builder(g)
+								.with_epsilon("ε")
+								.with_end_marker("$")
+								.with_augmented_start("E'")
+								.build()
+								.value();
+
+	EXPECT_EQ(stats.split_states(), 0);
+	EXPECT_EQ(lr1_table.goto_table(), lalr_table.goto_table());
+	ASSERT_EQ(lr1_table.action_table().size(), lalr_table.action_table().size());
+	for (const auto& [state, row] : lalr_table.action_table())
+	{
+		for (const auto& [terminal, act] : row)
+		{
+			const auto& other = lr1_table.get_action(state, terminal);
+			ASSERT_EQ(other.index(), act.index()) << state << " " << terminal;
+			if (lr::actions::is_shift(act))
+			{
+				EXPECT_EQ(lr::actions::as_shift(other).target_state, lr::actions::as_shift(act).target_state);
+			}
+			else if (lr::actions::is_reduce(act))
+			{
+				EXPECT_EQ(lr::actions::as_reduce(other), lr::actions::as_reduce(act));
+			}
+		}
+	}
+}
+
+namespace
+{
+std::size_t count_trees(const glr::forest_node* node, std::map<const glr::forest_node*, std::size_t>& memo)
+{
+	if (node->is_leaf())
+	{
+		return 1;
+	}
+	if (const auto it = memo.find(node); it != memo.end())
+	{
+		return it->second;
+	}
+
+	std::size_t total = 0;
+	for (const auto& family : node->families)
+	{
+		std::size_t product = 1;
+		for (const auto* child : family.children)
+		{
+			product *= count_trees(child, memo);
+		}
+		total += product;
+	}
+
+	return memo[node] = total;
+}
+
+std::size_t count_trees(const glr::forest_node* node)
+{
+	std::map<const glr::forest_node*, std::size_t> memo;
+
+	return count_trees(node, memo);
+}
+} // namespace
+
+// E -> E + E | E * E | id
+TEST(GlrParser, BuildsSharedForestOfAmbiguousGrammar)
+{
+	basic_cfg<std::string> g(
+		{ "E'", "E" }, { "+", "*", "id" },
+		{ { "E'", { "E" } },
+			{ "E", { "E", "+", "E" } },
+			{ "E", { "E", "*", "E" } },
+			{ "E", { "id" } } },
+		"E'");
+
+	const auto builder = lalr::table_builder(g)
+							 .with_epsilon("ε")
+							 .with_end_marker("$")
+							 .with_augmented_start("E'");
+	ASSERT_FALSE(builder.build().has_value());
+
+	const auto table = builder.build(lr::collision_policy::keep_all).value();
+	EXPECT_FALSE(table.conflict_table().empty());
+
+	glr::parser p(table);
+	const std::vector<std::string> three = { "id", "+", "id", "*", "id" };
+	const auto root = p.parse(three);
+	ASSERT_TRUE(root.has_value());
+	EXPECT_EQ(p.symbol(**root), "E");
+	EXPECT_EQ((*root)->start, 0);
+	EXPECT_EQ((*root)->end, 5);
+	EXPECT_TRUE((*root)->is_ambiguous());
+	EXPECT_EQ(count_trees(*root), 2);
+
+	// Catalan(4): every bracketing of five operands.
+	const std::vector<std::string> five = { "id", "+", "id", "+", "id", "*", "id", "+", "id" };
+	EXPECT_EQ(count_trees(p.parse(five).value()), 14);
+	EXPECT_LT(p.stats().deterministic_levels, p.stats().levels);
+
+	const auto error = p.parse(std::vector<std::string>{ "id", "+", "+" });
+	ASSERT_FALSE(error.has_value());
+	EXPECT_EQ(error.error().unexpected_token, "+");
+	EXPECT_EQ(error.error().expected_tokens, (std::vector<std::string>{ "id" }));
+
+	const auto compact = builder.build_compact(lr::collision_policy::keep_all).value();
+	glr::parser compact_parser(compact);
+	EXPECT_EQ(count_trees(compact_parser.parse(five).value()), 14);
+
+	std::stringstream buffer;
+	lr::io::save_to_binary(table, buffer);
+	const auto loaded = lr::io::load_from_binary<std::string>(buffer);
+	EXPECT_EQ(loaded.conflict_table(), table.conflict_table());
+}
+
+TEST(GlrParser, ParsesDeterministicInputOnSingleStack)
+{
+	basic_cfg<std::string> g(
+		{ "E'", "E", "T", "F" }, { "+", "*", "(", ")", "id" },
+		{ { "E'", { "E" } },
+			{ "E", { "E", "+", "T" } },
+			{ "E", { "T" } },
+			{ "T", { "T", "*", "F" } },
+			{ "T", { "F" } },
+			{ "F", { "(", "E", ")" } },
+			{ "F", { "id" } } },
+		"E'");
+
+	const auto table = lalr::table_builder(g)
+						   .with_epsilon("ε")
+						   .with_end_marker("$")
+						   .with_augmented_start("E'")
+						   .build(lr::collision_policy::keep_all)
+						   .value();
+	EXPECT_TRUE(table.conflict_table().empty());
+
+	glr::parser p(table);
+	const std::vector<std::string> input = { "(", "id", "+", "id", ")", "*", "id" };
+	const auto root = p.parse(input);
+	ASSERT_TRUE(root.has_value());
+	EXPECT_EQ(count_trees(*root), 1);
+
+	// E -> T, T -> T * F
+	const auto* term = (*root)->families.front().children.front();
+	EXPECT_EQ(p.symbol(*term), "T");
+	EXPECT_EQ(term->families.front().children.size(), 3);
+	EXPECT_EQ(p.stats().deterministic_levels, p.stats().levels);
+}
+
+// S -> A S b | B S b | c,  A -> ε | a,  B -> ε
+TEST(GlrParser, HandlesEpsilonRulesBetweenForks)
+{
+	basic_cfg<std::string> g(
+		{ "S'", "S", "A", "B" }, { "a", "b", "c" },
+		{ { "S'", { "S" } },
+			{ "S", { "A", "S", "b" } },
+			{ "S", { "B", "S", "b" } },
+			{ "S", { "c" } },
+			{ "A", { "ε" } },
+			{ "A", { "a" } },
+			{ "B", { "ε" } } },
+		"S'");
+
+	const auto table = lalr::table_builder(g)
+						   .with_epsilon("ε")
+						   .with_end_marker("$")
+						   .with_augmented_start("S'")
+						   .build(lr::collision_policy::keep_all)
+						   .value();
+
+	glr::parser p(table);
+	// Each `b` closes an S that starts with `a`, A -> ε or B -> ε.
+	EXPECT_EQ(count_trees(p.parse(std::vector<std::string>{ "c", "b" }).value()), 2);
+	EXPECT_EQ(count_trees(p.parse(std::vector<std::string>{ "c", "b", "b" }).value()), 4);
+	EXPECT_EQ(count_trees(p.parse(std::vector<std::string>{ "a", "c", "b", "b" }).value()), 4);
+	EXPECT_FALSE(p.parse(std::vector<std::string>{ "c", "b", "a" }).has_value());
+}
+
+namespace
+{
+bool same_tree(const lr::syntax_node& a, const lr::syntax_node& b)
+{
+	if (a.rule_index != b.rule_index || a.left_state != b.left_state || a.token_count != b.token_count
+		|| a.children.size() != b.children.size())
+	{
+		return false;
+	}
+
+	for (std::size_t i = 0; i < a.children.size(); ++i)
+	{
+		if (!same_tree(*a.children[i], *b.children[i]))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+} // namespace
+
+// P -> P S | S,  S -> id = E ;,  E -> E + T | T,  T -> id | num | ( E )
+TEST(IncrementalParser, ReparsesOnlyTheEditedStatement)
+{
+	basic_cfg<std::string> g(
+		{ "P'", "P", "S", "E", "T" }, { "id", "num", "=", ";", "+", "(", ")" },
+		{ { "P'", { "P" } },
+			{ "P", { "P", "S" } },
+			{ "P", { "S" } },
+			{ "S", { "id", "=", "E", ";" } },
+			{ "E", { "E", "+", "T" } },
+			{ "E", { "T" } },
+			{ "T", { "id" } },
+			{ "T", { "num" } },
+			{ "T", { "(", "E", ")" } } },
+		"P'");
+
+	const auto table = lalr::table_builder(g)
+						   .with_epsilon("ε")
+						   .with_end_marker("$")
+						   .with_augmented_start("P'")
+						   .build()
+						   .value();
+
+	std::vector<std::string> input;
+	for (int i = 0; i < 200; ++i)
+	{
+		input.insert(input.end(), { "id", "=", "id", "+", "num", ";" });
+	}
+
+	lr::incremental_parser p(table);
+	const auto tree = p.parse(input).value();
+	EXPECT_EQ(tree->token_count, input.size());
+	EXPECT_EQ(p.stats().reused_tokens, 0);
+
+	// `num` of statement 100 becomes `( id + num )`.
+	const lr::token_edit edit{ .offset = 100 * 6 + 4, .removed = 1, .inserted = 5 };
+	auto edited = input;
+	edited.erase(edited.begin() + edit.offset);
+	edited.insert(edited.begin() + edit.offset, { "(", "id", "+", "num", ")" });
+
+	const auto reparsed = p.reparse(tree, edited, edit).value();
+	EXPECT_GE(p.stats().reused_tokens, input.size() - 6);
+	EXPECT_LE(p.stats().reused_tokens, input.size() - edit.removed);
+	const auto first_statements = [](lr::syntax_tree node) {
+		while (node->token_count > 100 * 6)
+		{
+			node = node->children.front();
+		}
+		return node;
+	};
+	EXPECT_EQ(first_statements(reparsed), first_statements(tree)) << "The first 100 statements are shared";
+
+	lr::incremental_parser fresh(table);
+	EXPECT_TRUE(same_tree(*reparsed, *fresh.parse(edited).value()));
+
+	// Appending a statement keeps everything before the last `;`.
+	auto appended = edited;
+	appended.insert(appended.end(), { "id", "=", "num", ";" });
+	const auto longer = p.reparse(reparsed, appended, { .offset = edited.size(), .removed = 0, .inserted = 4 }).value();
+	EXPECT_TRUE(same_tree(*longer, *fresh.parse(appended).value()));
+	EXPECT_GE(p.stats().reused_tokens, edited.size() - 6);
+
+	auto broken = input;
+	broken[7] = ";";
+	const auto error = p.reparse(tree, broken, { .offset = 7, .removed = 1, .inserted = 1 });
+	ASSERT_FALSE(error.has_value());
+	EXPECT_EQ(error.error().unexpected_token, ";");
+
+	EXPECT_THROW((void)p.reparse(tree, broken, { .offset = 7, .removed = 1, .inserted = 2 }), std::invalid_argument);
+}
+
+TEST(RegexPrefilter, ExtractsPrefixAndRequiredLiteral)
+{
+	const regex re("ab(c|d)*xyz");
+	const auto literals = details::literal_extractor{}(re.syntax_tree());
+
+	EXPECT_EQ(literals.prefix, "ab");
+	EXPECT_EQ(literals.required, "xyz");
+	EXPECT_TRUE(literals.first_bytes.test('a'));
+	EXPECT_EQ(literals.first_bytes.count(), 1);
+	EXPECT_FALSE(literals.nullable);
+}
+
+TEST(RegexPrefilter, AlternationKeepsCommonLiterals)
+{
+	const regex re("(error|warn)(0|1)*: disk");
+	const auto literals = details::literal_extractor{}(re.syntax_tree());
+
+	EXPECT_TRUE(literals.prefix.empty());
+	EXPECT_EQ(literals.required, ": disk");
+	EXPECT_TRUE(literals.first_bytes.test('e'));
+	EXPECT_TRUE(literals.first_bytes.test('w'));
+	EXPECT_EQ(literals.first_bytes.count(), 2);
+}
+
+TEST(RegexPrefilter, SearchSkipsInputWithoutRequiredLiteral)
+{
+	auto matcher = fsm_regex_matcher::compile("id=(0|1|2|3)+");
+	matcher.prefilter.with_stats();
+
+	const std::string noise(4096, 'x');
+	EXPECT_FALSE(matcher.search(noise).has_value());
+	EXPECT_EQ(matcher.prefilter.stats().hits, 0);
+	EXPECT_EQ(matcher.prefilter.stats().misses, 1);
+	EXPECT_EQ(matcher.prefilter.stats().skipped_bytes, noise.size());
+
+	matcher.prefilter.reset_stats();
+
+	const std::string line = noise + "id=x id=123;";
+	const auto match = matcher.search(line);
+	ASSERT_TRUE(match.has_value());
+	EXPECT_EQ(match->offset, noise.size() + 5);
+	EXPECT_EQ(match->length, 6);
+	EXPECT_EQ(matcher.prefilter.stats().hits, 2);
+}
+
+TEST(RegexPrefilter, AnchoredMatchRejectsWrongPrefix)
+{
+	auto matcher = fsm_regex_matcher::compile("begin");
+	EXPECT_FALSE(matcher.prefilter.counts_stats());
+	EXPECT_EQ(matcher.find_match("xbegin", 0), 0);
+	EXPECT_EQ(matcher.prefilter.stats().misses, 0);
+
+	matcher.prefilter.with_stats();
+	EXPECT_EQ(matcher.find_match("xbegin", 0), 0);
+	EXPECT_EQ(matcher.find_match("xbegin", 1), 5);
+	EXPECT_EQ(matcher.prefilter.stats().misses, 1);
+	EXPECT_EQ(matcher.prefilter.stats().hits, 1);
+}
+
+TEST(RegexPrefilter, CountsMatchesFromSharedMatcher)
+{
+	auto matcher = fsm_regex_matcher::compile("begin");
+	matcher.prefilter.with_stats();
+
+	{
+		std::vector<std::jthread> workers;
+		for (int i = 0; i < 4; ++i)
+		{
+			workers.emplace_back([&matcher] {
+				for (int n = 0; n < 1000; ++n)
+				{
+					(void)matcher.find_match("xbegin", n % 2);
+				}
+			});
+		}
+	}
+
+	EXPECT_EQ(matcher.prefilter.stats().hits, 2000);
+	EXPECT_EQ(matcher.prefilter.stats().misses, 2000);
+}
+
+TEST(RegexPrefilter, ParallelTokenizeMergesWorkerStats)
+{
+	const std::string source = "var x : int ;\n x = 12 + y * 3 ;\n y = x - 7 ;\n";
+	auto rules = std::vector<lexer<std::string>::rule>{
+		{ "KW", fsm_regex_matcher::compile("var|int"), false },
+		{ "ID", fsm_regex_matcher::compile("(x|y)+"), false },
+		{ "NUM", fsm_regex_matcher::compile("(0|1|2|3|4|5|6|7|8|9)+"), false },
+		{ "OP", fsm_regex_matcher::compile(":|;|=|\\+|-|\\*"), false },
+		{ "WS", fsm_regex_matcher::compile("( |\n)+"), true },
+	};
+	for (auto& rule : rules)
+	{
+		rule.matcher.prefilter.with_stats();
+	}
+
+	lexer<std::string> sequential(source, rules);
+	ASSERT_TRUE(sequential.tokenize().has_value());
+	lexer<std::string> parallel(source, rules);
+	ASSERT_TRUE(parallel.tokenize_parallel(4).has_value());
+
+	for (std::size_t i = 0; i < rules.size(); ++i)
+	{
+		const auto expected = sequential.rules()[i].matcher.prefilter.stats();
+		const auto actual = parallel.rules()[i].matcher.prefilter.stats();
+		EXPECT_GE(actual.hits, expected.hits) << rules[i].type;
+		EXPECT_GT(actual.hits + actual.misses, 0) << rules[i].type;
+	}
+}
+
+TEST(FsmRegexMatcher, LongestMatchAgreesWithStdRegex)
+{
+	const std::vector<std::string> patterns = { "a(b|c)*d", "(0|1)+", "(if)+x", "x(yz)*" };
+	const std::vector<std::string> inputs = { "abcbd!", "abc", "0110a", "ififx", "if", "xyzyzy", "q" };
+
+	for (auto const& pattern : patterns)
+	{
+		const auto fsm = fsm_regex_matcher::compile(pattern);
+		const auto reference = std_regex_matcher::compile(pattern);
+		for (auto const& input : inputs)
+		{
+			EXPECT_EQ(fsm.find_match(input, 0), reference.find_match(input, 0)) << pattern << " on " << input;
+		}
+	}
+}
+
+TEST(FsmRegexMatcher, StartPastEndFindsNothing)
+{
+	const std::string input = "xyz";
+	const auto fsm = fsm_regex_matcher::compile("x(yz)*");
+	const auto reference = std_regex_matcher::compile("x(yz)*");
+
+	EXPECT_EQ(fsm.find_match(input, input.size() + 1), 0);
+	EXPECT_EQ(reference.find_match(input, input.size() + 1), 0);
+	EXPECT_FALSE(fsm.search(input, input.size() + 1).has_value());
+	EXPECT_FALSE(reference.search(input, input.size() + 1).has_value());
+}
+
+TEST(FsmRegexMatcher, CompilesToMinimalByteTable)
+{
+	const auto matcher = fsm_regex_matcher::compile("(a|b)*abb");
+
+	// Dead state plus the four states of the textbook minimal DFA.
+	EXPECT_EQ(matcher.dfa.state_count(), 5);
+	// 'a', 'b' and every other byte.
+	EXPECT_EQ(matcher.dfa.class_count, 3);
+	EXPECT_EQ(matcher.find_match("babbabb", 0), 7);
+	EXPECT_EQ(matcher.find_match("babba", 0), 4);
+}
+
+TEST(RegexSet, ReportsAllPatternsMatchingWholeInput)
+{
+	const regex_set set({ "ab", "a(b|c)", "x+", "(a|b)*" });
+
+	EXPECT_EQ(set.matches("ab").ids(), (std::vector<std::size_t>{ 0, 1, 3 }));
+	EXPECT_EQ(set.matches("ac").ids(), (std::vector<std::size_t>{ 1 }));
+	EXPECT_EQ(set.matches("xxx").ids(), (std::vector<std::size_t>{ 2 }));
+	EXPECT_EQ(set.matches("").ids(), (std::vector<std::size_t>{ 3 }));
+	EXPECT_TRUE(set.matches("abc").none());
+}
+
+TEST(RegexSet, AgreesWithSeparateRecognizers)
+{
+	const std::vector<std::string> patterns = { "(0|1)+", "1(0|1)*0", "0*1", "(01)+" };
+	const regex_set set(patterns);
+
+	for (const std::string input : { "0", "1", "10", "0101", "001", "110", "2" })
+	{
+		const auto matched = set.matches(input);
+		for (std::size_t id = 0; id < patterns.size(); ++id)
+		{
+			auto machine = minimize(determinize(regex(patterns[id]).compile()));
+
+			std::vector<std::optional<std::string>> symbols;
+			for (const char c : input)
+			{
+				symbols.emplace_back(std::string(1, c));
+			}
+
+			EXPECT_EQ(matched.test(id), recognize(machine, symbols)) << patterns[id] << " on " << input;
+		}
+	}
+}
+
+TEST(RegexSet, AnywhereModeMatchesSubstrings)
+{
+	const regex_set set({ "error", "warn(ing)*", "disk" }, regex_set::match_mode::anywhere);
+
+	EXPECT_EQ(set.matches("[12:00] warning: disk full").ids(), (std::vector<std::size_t>{ 1, 2 }));
+	EXPECT_EQ(set.matches("error").ids(), (std::vector<std::size_t>{ 0 }));
+	EXPECT_TRUE(set.matches("all good").none());
+}
+
+template <typename T_Matcher = fsm_regex_matcher>
+std::vector<typename lexer<std::string, T_Matcher>::rule> lang_rules()
+{
+	return lexer_spec_load<std::string, T_Matcher>(mapped_source("res/lang_grammar.txt"));
+}
+
+std::string read_lang_source()
+{
+	std::ifstream file("res/lang_src.txt");
+	return { std::istreambuf_iterator(file), std::istreambuf_iterator<char>() };
+}
+
+TEST(CombinedLexer, ProducesSameTokensAsPerRuleMatchers)
+{
+	const auto source = read_lang_source();
+
+	lexer<std::string> reference(source, lang_rules());
+	lexer<std::string, combined_dfa_matcher> combined(source, lang_rules<combined_dfa_matcher>());
+
+	const auto expected = reference.tokenize();
+	const auto actual = combined.tokenize();
+
+	ASSERT_TRUE(expected.has_value());
+	ASSERT_TRUE(actual.has_value());
+	ASSERT_EQ(actual->size(), expected->size());
+	ASSERT_FALSE(actual->empty());
+
+	for (std::size_t i = 0; i < actual->size(); ++i)
+	{
+		EXPECT_EQ((*actual)[i].type, (*expected)[i].type);
+		EXPECT_EQ((*actual)[i].lexeme, (*expected)[i].lexeme);
+		EXPECT_EQ((*actual)[i].line, (*expected)[i].line);
+		EXPECT_EQ((*actual)[i].column, (*expected)[i].column);
+	}
+}
+
+TEST(CombinedLexer, EarlierRuleWinsOnEqualLength)
+{
+	lexer<std::string, combined_dfa_matcher> lex("if iff");
+	lex.add_rule("if", "KW_IF")
+		.add_rule("(a|b|c|d|e|f|g|h|i)+", "IDENTIFIER")
+		.add_rule(" ", "SPACE", true);
+
+	const auto tokens = lex.tokenize();
+	ASSERT_TRUE(tokens.has_value());
+	ASSERT_EQ(tokens->size(), 2);
+	EXPECT_EQ((*tokens)[0].type, "KW_IF");
+	EXPECT_EQ((*tokens)[1].type, "IDENTIFIER");
+	EXPECT_EQ((*tokens)[1].lexeme, "iff");
+}
+
+TEST(CombinedLexer, ReportsUnexpectedCharacter)
+{
+	lexer<std::string, combined_dfa_matcher> lex("ab?");
+	lex.add_rule("(a|b)+", "AB");
+
+	auto first = lex.next();
+	ASSERT_TRUE(first.has_value() && first->has_value());
+	EXPECT_EQ((*first)->lexeme, "ab");
+
+	auto second = lex.next();
+	ASSERT_TRUE(second.has_value());
+	ASSERT_FALSE(second->has_value());
+	EXPECT_EQ(second->error().unexpected_char, '?');
+	EXPECT_EQ(second->error().column, 3);
+}
+
+template <typename T_Matcher>
+void expect_stream_matches_whole_source(const std::size_t chunk_size)
+{
+	const auto source = read_lang_source();
+
+	lexer<std::string, T_Matcher> reference(source, lang_rules<T_Matcher>());
+	const auto expected = reference.tokenize();
+	ASSERT_TRUE(expected.has_value());
+
+	std::istringstream input(source);
+	stream_lexer<std::string, T_Matcher> streaming(input, lang_rules<T_Matcher>(), chunk_size);
+
+	std::size_t index = 0;
+	while (auto token = streaming.next())
+	{
+		ASSERT_TRUE(token->has_value());
+		ASSERT_LT(index, expected->size());
+
+		auto const& reference_token = (*expected)[index++];
+		EXPECT_EQ((*token)->type, reference_token.type);
+		EXPECT_EQ((*token)->lexeme, reference_token.lexeme);
+		EXPECT_EQ((*token)->offset, reference_token.offset);
+		EXPECT_EQ((*token)->line, reference_token.line);
+		EXPECT_EQ((*token)->column, reference_token.column);
+	}
+	EXPECT_EQ(index, expected->size());
+}
+
+TEST(StreamLexer, MatchesWholeSourceLexerForAnyChunkSize)
+{
+	for (const std::size_t chunk_size : { 1, 7, 4096 })
+	{
+		expect_stream_matches_whole_source<fsm_regex_matcher>(chunk_size);
+		expect_stream_matches_whole_source<combined_dfa_matcher>(chunk_size);
+	}
+}
+
+TEST(StreamLexer, CarriesTokenAcrossChunkBoundary)
+{
+	const std::string text = "aaaaaaaaab?";
+	std::size_t served = 0;
+	std::size_t pulls = 0;
+
+	stream_lexer<std::string> lex([&](std::span<char> buffer) {
+		++pulls;
+		const std::size_t count = std::min(buffer.size(), text.size() - served);
+		std::copy_n(text.data() + served, count, buffer.data());
+		served += count;
+		return count;
+	},
+		4);
+	lex.add_rule("a+b", "AB");
+
+	auto first = lex.next_owned();
+	ASSERT_TRUE(first.has_value() && first->has_value());
+	EXPECT_EQ((*first)->lexeme, "aaaaaaaaab");
+	EXPECT_EQ((*first)->offset, 0);
+	EXPECT_GE(pulls, 3);
+
+	auto second = lex.next();
+	ASSERT_TRUE(second.has_value());
+	ASSERT_FALSE(second->has_value());
+	EXPECT_EQ(second->error().unexpected_char, '?');
+	EXPECT_EQ(second->error().offset, 10);
+
+	EXPECT_FALSE(lex.next().has_value());
+}
+
+TEST(MappedSource, ViewsFileContentsWithoutCopy)
+{
+	const mapped_source source("res/lang_src.txt");
+	EXPECT_EQ(source.view(), read_lang_source());
+
+	lexer<std::string> lex(source, lang_rules());
+	const auto tokens = lex.tokenize();
+	ASSERT_TRUE(tokens.has_value());
+	ASSERT_FALSE(tokens->empty());
+	EXPECT_EQ(tokens->front().lexeme.data(), source.data());
+}
+
+TEST(MappedSource, LoadsGrammarLikeStream)
+{
+	std::ifstream file("res/cfg_prog_lang.txt");
+	const auto expected = cfg_load(file);
+	const auto actual = cfg_load(mapped_source("res/cfg_prog_lang.txt"));
+
+	EXPECT_EQ(actual.rules(), expected.rules());
+	EXPECT_EQ(actual.start_symbol(), expected.start_symbol());
+}
+
+TEST(MappedSource, HandlesEmptyAndMissingFiles)
+{
+	const auto path = std::filesystem::temp_directory_path() / "fsm_empty_source.txt";
+	std::ofstream(path).close();
+	{
+		const mapped_source empty(path);
+		EXPECT_TRUE(empty.empty());
+		EXPECT_EQ(empty.view(), "");
+	}
+	std::filesystem::remove(path);
+
+	EXPECT_THROW(mapped_source("res/does_not_exist.txt"), std::runtime_error);
+}
+
+template <typename T_Matcher>
+void expect_parallel_matches_sequential(std::string const& source)
+{
+	lexer<std::string, T_Matcher> sequential(source, lang_rules<T_Matcher>());
+	const auto expected = sequential.tokenize();
+
+	for (const std::size_t threads : { 2, 7, 64 })
+	{
+		lexer<std::string, T_Matcher> parallel(source, lang_rules<T_Matcher>());
+		const auto actual = parallel.tokenize_parallel(threads);
+
+		ASSERT_EQ(actual.has_value(), expected.has_value()) << threads;
+		if (!expected)
+		{
+			EXPECT_EQ(actual.error().offset, expected.error().offset);
+			EXPECT_EQ(actual.error().line, expected.error().line);
+			EXPECT_EQ(actual.error().column, expected.error().column);
+			continue;
+		}
+
+		ASSERT_EQ(actual->size(), expected->size()) << threads;
+		for (std::size_t i = 0; i < actual->size(); ++i)
+		{
+			EXPECT_EQ((*actual)[i].type, (*expected)[i].type);
+			EXPECT_EQ((*actual)[i].offset, (*expected)[i].offset);
+			EXPECT_EQ((*actual)[i].length, (*expected)[i].length);
+			EXPECT_EQ((*actual)[i].line, (*expected)[i].line);
+			EXPECT_EQ((*actual)[i].column, (*expected)[i].column);
+		}
+	}
+}
+
+TEST(ParallelLexer, MatchesSequentialTokenize)
+{
+	std::string source;
+	for (int i = 0; i < 20; ++i)
+	{
+		source += read_lang_source();
+	}
+
+	expect_parallel_matches_sequential<fsm_regex_matcher>(source);
+	expect_parallel_matches_sequential<combined_dfa_matcher>(source);
+}
+
+TEST(ParallelLexer, ReportsFirstErrorLikeSequential)
+{
+	std::string source = read_lang_source();
+	source.insert(source.size() / 3, "?");
+	source.insert(2 * source.size() / 3, "!");
+
+	expect_parallel_matches_sequential<combined_dfa_matcher>(source);
+}
+
+TEST(LineIndex, MapsOffsetsToLinesAndColumns)
+{
+	const line_index lines("ab\ncd\n\nef");
+
+	EXPECT_EQ(lines.line_count(), 4);
+	EXPECT_EQ(lines.at(0), (source_position{ 1, 1 }));
+	EXPECT_EQ(lines.at(2), (source_position{ 1, 3 }));
+	EXPECT_EQ(lines.at(3), (source_position{ 2, 1 }));
+	EXPECT_EQ(lines.at(6), (source_position{ 3, 1 }));
+	EXPECT_EQ(lines.at(8), (source_position{ 4, 2 }));
+}
+
+TEST(LineIndex, LazyTrackingReportsSamePositions)
+{
+	const auto source = read_lang_source();
+
+	lexer<std::string> eager(source, lang_rules());
+	const auto expected = eager.tokenize();
+
+	lexer<std::string> lazy(source, lang_rules());
+	lazy.with_position_tracking(position_tracking::lazy);
+	const auto actual = lazy.tokenize();
+
+	ASSERT_TRUE(expected.has_value() && actual.has_value());
+	ASSERT_EQ(actual->size(), expected->size());
+	for (std::size_t i = 0; i < actual->size(); ++i)
+	{
+		EXPECT_EQ((*actual)[i].line, 0);
+		EXPECT_EQ((*actual)[i].position(lazy.lines()), (source_position{ (*expected)[i].line, (*expected)[i].column }));
+	}
+
+	lexer<std::string> broken("ab\n a?");
+	broken.add_rule("(a|b)+", "AB").add_rule("( |\n)+", "WS", true);
+	broken.with_position_tracking(position_tracking::lazy);
+	const auto error = broken.tokenize();
+	ASSERT_FALSE(error.has_value());
+	EXPECT_EQ(error.error().line, 2);
+	EXPECT_EQ(error.error().column, 3);
+}
+
+TEST(ScannerGenerator, GeneratedScannerMatchesLexer)
+{
+	const auto source = read_lang_source();
+
+	lexer<std::string> reference(source, lang_rules());
+	const auto expected = reference.tokenize();
+
+	lang::lang_scanner scanner(source);
+	const auto actual = scanner.tokenize();
+
+	ASSERT_TRUE(expected.has_value() && actual.has_value());
+	ASSERT_EQ(actual->size(), expected->size());
+	for (std::size_t i = 0; i < actual->size(); ++i)
+	{
+		EXPECT_EQ(lang::to_string((*actual)[i].type), (*expected)[i].type);
+		EXPECT_EQ((*actual)[i].lexeme, (*expected)[i].lexeme);
+		EXPECT_EQ((*actual)[i].line, (*expected)[i].line);
+		EXPECT_EQ((*actual)[i].column, (*expected)[i].column);
+	}
+
+	scanner.change_source("main ?");
+	EXPECT_EQ((*scanner.next())->type, lang::token_type::KW_MAIN);
+	const auto error = scanner.next();
+	ASSERT_TRUE(error.has_value() && !error->has_value());
+	EXPECT_EQ(error->error().column, 6);
+}
+
+TEST(ScannerGenerator, RejectsTokenTypesThatAreNotIdentifiers)
+{
+	std::ostringstream out;
+	EXPECT_THROW(generate_scanner(out, { { "a", "not-a-name" } }), std::invalid_argument);
+}
+
+TEST(ScannerGenerator, IncludeGuardKeepsDigits)
+{
+	std::ostringstream out;
+	generate_scanner(out, { { "a", "A" } }, { .class_name = "lexer2", .namespace_name = "v2", .include_guard = "" });
+	EXPECT_NE(out.str().find("#ifndef V2_LEXER2_HPP"), std::string::npos);
+}
+
+TEST(LexerCache, RoundTripsCompiledAutomaton)
+{
+	const auto source = read_lang_source();
+
+	lexer<std::string, combined_dfa_matcher> original(source, lang_rules<combined_dfa_matcher>());
+	const auto expected = original.tokenize();
+
+	std::ostringstream out;
+	save_lexer_cache(original, out);
+	const std::string bytes = out.str();
+
+	const auto view = lexer_cache_view::open(bytes);
+	ASSERT_TRUE(view.has_value());
+	EXPECT_EQ(view->rules_hash(), lexer_rules_hash(original.rules()));
+	ASSERT_EQ(view->rules().size(), original.rules().size());
+	EXPECT_EQ(view->rules().back().pattern, original.rules().back().matcher.pattern);
+	EXPECT_TRUE(view->rules().back().skip);
+
+	lexer<std::string, combined_dfa_matcher> restored(source, original.rules());
+	restored.with_engine(combined_dfa_matcher::engine(view->dfa()));
+	const auto actual = restored.tokenize();
+
+	ASSERT_TRUE(expected.has_value() && actual.has_value());
+	ASSERT_EQ(actual->size(), expected->size());
+	for (std::size_t i = 0; i < actual->size(); ++i)
+	{
+		EXPECT_EQ((*actual)[i].type, (*expected)[i].type);
+		EXPECT_EQ((*actual)[i].lexeme, (*expected)[i].lexeme);
+	}
+}
+
+TEST(LexerCache, RejectsDamagedFiles)
+{
+	lexer<std::string, combined_dfa_matcher> lex("");
+	lex.add_rule("(a|b)+", "AB").add_rule(" ", "SPACE", true);
+
+	std::ostringstream out;
+	save_lexer_cache(lex, out);
+	const std::string bytes = out.str();
+	ASSERT_TRUE(lexer_cache_view::open(bytes).has_value());
+
+	std::string flipped = bytes;
+	flipped[flipped.size() / 2] ^= 0x40;
+	EXPECT_FALSE(lexer_cache_view::open(flipped).has_value());
+
+	EXPECT_FALSE(lexer_cache_view::open(std::string_view(bytes).substr(0, bytes.size() - 4)).has_value());
+	EXPECT_FALSE(lexer_cache_view::open("").has_value());
+}
+
+TEST(LexerCache, RebuildsStaleCache)
+{
+	const std::filesystem::path path = "res/lexer_cache_test.bin";
+	std::filesystem::remove(path);
+
+	auto rules = lang_rules<combined_dfa_matcher>();
+
+	const auto built = cached_lexer<std::string>::load_or_build(path, rules);
+	EXPECT_FALSE(built.loaded_from_cache());
+	ASSERT_TRUE(std::filesystem::exists(path));
+
+	const auto loaded = cached_lexer<std::string>::load_or_build(path, rules);
+	EXPECT_TRUE(loaded.loaded_from_cache());
+
+	const auto source = read_lang_source();
+	auto from_build = built.make_lexer(source);
+	auto from_cache = loaded.make_lexer(source);
+	const auto expected = from_build.tokenize();
+	const auto actual = from_cache.tokenize();
+	ASSERT_TRUE(expected.has_value() && actual.has_value());
+	ASSERT_EQ(actual->size(), expected->size());
+	for (std::size_t i = 0; i < actual->size(); ++i)
+	{
+		EXPECT_EQ((*actual)[i].type, (*expected)[i].type);
+		EXPECT_EQ((*actual)[i].lexeme, (*expected)[i].lexeme);
+	}
+
+	rules.front().matcher = combined_dfa_matcher::compile("mainx");
+	const auto stale = cached_lexer<std::string>::load_or_build(path, rules);
+	EXPECT_FALSE(stale.loaded_from_cache());
+	EXPECT_TRUE(cached_lexer<std::string>::load_or_build(path, rules).loaded_from_cache());
+}
+
+TEST(LexerSpec, LoadsRulesInFileOrder)
+{
+	std::istringstream spec(R"(
+# keywords first
+KW_IF if
+ID (a|b|i|f)+
+
+%skip WS ( |\n)+
+KW_ALSO_IF if
+)");
+
+	const auto rules = lexer_spec_load(spec, 4);
+	ASSERT_EQ(rules.size(), 4);
+	EXPECT_EQ(rules[0].type, "KW_IF");
+	EXPECT_EQ(rules[2].type, "WS");
+	EXPECT_TRUE(rules[2].skip);
+	EXPECT_FALSE(rules[3].skip);
+
+	lexer<std::string> lex("if iff", rules);
+	const auto tokens = lex.tokenize();
+	ASSERT_TRUE(tokens.has_value());
+	ASSERT_EQ(tokens->size(), 2);
+	EXPECT_EQ((*tokens)[0].type, "KW_IF");
+	EXPECT_EQ((*tokens)[1].type, "ID");
+}
+
+TEST(LexerSpec, ReportsLineOfBadRule)
+{
+	std::istringstream missing_pattern("A a\nB\n");
+	EXPECT_THROW(lexer_spec_load(missing_pattern), std::runtime_error);
+
+	std::istringstream bad_pattern("A a\nB *b\n");
+	try
+	{
+		std::ignore = lexer_spec_load(bad_pattern);
+		FAIL() << "expected an exception";
+	}
+	catch (std::runtime_error const& e)
+	{
+		EXPECT_TRUE(std::string(e.what()).starts_with("Invalid pattern at line 2")) << e.what();
+	}
+}
+
+TEST(TokenBuffer, MatchesTokenizeAcrossFlushes)
+{
+	const auto source = read_lang_source();
+
+	lexer<std::string, combined_dfa_matcher> reference(source, lang_rules<combined_dfa_matcher>());
+	const auto expected = reference.tokenize();
+	ASSERT_TRUE(expected.has_value());
+
+	lexer<std::string, combined_dfa_matcher> lex(source, lang_rules<combined_dfa_matcher>());
+	token_buffer<std::string> buffer(5);
+	std::vector<std::tuple<std::string, std::size_t, std::size_t>> collected;
+	const auto collect = [&](token_buffer<std::string> const& batch) {
+		for (std::size_t i = 0; i < batch.size(); ++i)
+		{
+			collected.emplace_back(batch.types()[i], batch.offsets()[i], batch.lengths()[i]);
+		}
+	};
+
+	std::size_t flushes = 0;
+	const auto total = lex.tokenize_into(buffer, [&](token_buffer<std::string>& full) {
+		EXPECT_TRUE(full.full());
+		collect(full);
+		flushes++;
+	});
+	collect(buffer);
+
+	ASSERT_TRUE(total.has_value());
+	EXPECT_EQ(*total, expected->size());
+	EXPECT_EQ(flushes, (expected->size() - 1) / 5);
+	ASSERT_EQ(collected.size(), expected->size());
+	for (std::size_t i = 0; i < collected.size(); ++i)
+	{
+		EXPECT_EQ(std::get<0>(collected[i]), (*expected)[i].type);
+		EXPECT_EQ(std::get<1>(collected[i]), (*expected)[i].offset);
+		EXPECT_EQ(std::get<2>(collected[i]), (*expected)[i].length);
+	}
+
+	const auto& last = expected->back();
+	EXPECT_EQ(buffer.lexeme(buffer.size() - 1, source), last.lexeme);
+	EXPECT_EQ(buffer.position(buffer.size() - 1, lex.lines()), (source_position{ last.line, last.column }));
+}
+
+TEST(TokenBuffer, FeedsParserInBatches)
+{
+	const basic_cfg<std::string> grammar(
+		{ "S'", "S", "L", "R" }, { "=", "*", "id" },
+		{ { "S'", { "S" } },
+			{ "S", { "L", "=", "R" } },
+			{ "S", { "R" } },
+			{ "L", { "*", "R" } },
+			{ "L", { "id" } },
+			{ "R", { "L" } } },
+		"S'");
+	const auto table = lalr::table_builder(grammar)
+						   .with_epsilon("ε")
+						   .with_end_marker("$")
+						   .with_augmented_start("S'")
+						   .build();
+	ASSERT_TRUE(table.has_value());
+
+	lexer<std::string> lex("* id\n= id tail");
+	lex.add_rule("id", "id").add_rule("=", "=").add_rule("\\*", "*").add_rule("( |\n)+", "WS", true).add_rule("tail", "tail");
+
+	token_buffer<std::string> buffer(4);
+	const auto first = lex.tokenize_into(buffer);
+	ASSERT_TRUE(first.has_value());
+	EXPECT_EQ(*first, 4);
+	EXPECT_TRUE(buffer.full());
+
+	lr::parser p(*table, "ε");
+	bool accepted = false;
+	for (const auto& event : p.parse(buffer.types()))
+	{
+		ASSERT_FALSE(lr::events::is_error(event));
+		accepted = lr::events::is_accept(event);
+	}
+	EXPECT_TRUE(accepted);
+
+	buffer.clear();
+	const auto rest = lex.tokenize_into(buffer);
+	ASSERT_TRUE(rest.has_value());
+	EXPECT_EQ(*rest, 1);
+	EXPECT_EQ(buffer.types()[0], "tail");
+	EXPECT_EQ(buffer.position(0, lex.lines()), (source_position{ 2, 6 }));
+
+	buffer.clear();
+	EXPECT_EQ(lex.tokenize_into(buffer).value_or(1), 0);
+	EXPECT_THROW(token_buffer<std::string>(0), std::invalid_argument);
+}
+
+template <typename T_Matcher>
+void expect_relex_matches_tokenize(std::string source, source_edit edit)
+{
+	static const auto rules = lang_rules<T_Matcher>();
+
+	lexer<std::string, T_Matcher> lex(source, rules);
+	const auto old_tokens = lex.tokenize();
+	ASSERT_TRUE(old_tokens.has_value());
+
+	source.replace(edit.offset, edit.removed, edit.inserted);
+	lex.change_source(source);
+	const auto actual = lex.relex(*old_tokens, edit);
+
+	lexer<std::string, T_Matcher> reference(source, rules);
+	const auto expected = reference.tokenize();
+
+	ASSERT_EQ(actual.has_value(), expected.has_value()) << edit.offset;
+	if (!expected)
+	{
+		EXPECT_EQ(actual.error().offset, expected.error().offset);
+		EXPECT_EQ(actual.error().line, expected.error().line);
+		EXPECT_EQ(actual.error().column, expected.error().column);
+		return;
+	}
+
+	ASSERT_EQ(actual->size(), expected->size()) << edit.offset;
+	for (std::size_t i = 0; i < actual->size(); ++i)
+	{
+		EXPECT_EQ((*actual)[i].type, (*expected)[i].type) << i;
+		EXPECT_EQ((*actual)[i].lexeme, (*expected)[i].lexeme) << i;
+		EXPECT_EQ((*actual)[i].offset, (*expected)[i].offset) << i;
+		EXPECT_EQ((*actual)[i].line, (*expected)[i].line) << i;
+		EXPECT_EQ((*actual)[i].column, (*expected)[i].column) << i;
+	}
+}
+
+TEST(IncrementalLexer, MatchesFullTokenizeAfterEdits)
+{
+	const auto source = read_lang_source();
+	const std::vector<source_edit> edits = {
+		{ 0, 0, "x" },
+		{ 0, 4, "" },
+		{ 10, 0, "\n\n" },
+		{ 12, 3, "abc" },
+		{ source.size() / 2, 1, " " },
+		{ source.size() / 2, 0, "\n  y = 1;\n" },
+		{ source.size() - 1, 1, "" },
+		{ source.size(), 0, " z" },
+		{ 20, 0, "?" },
+	};
+
+	for (auto const& edit : edits)
+	{
+		expect_relex_matches_tokenize<fsm_regex_matcher>(source, edit);
+		expect_relex_matches_tokenize<combined_dfa_matcher>(source, edit);
+	}
+}
+
+TEST(Utf8Regex, CompilesCodePointClassesToByteSequences)
+{
+	const auto greek = utf8_regex_matcher::compile("[α-ω]+");
+	EXPECT_EQ(greek.find_match("αβγω!", 0), 8);
+	EXPECT_EQ(greek.find_match("abc", 0), 0);
+	EXPECT_EQ(greek.find_match("Ωα", 0), 0);
+
+	const auto repeated = utf8_regex_matcher::compile("é*x");
+	EXPECT_EQ(repeated.find_match("ééx", 0), 5);
+	EXPECT_EQ(fsm_regex_matcher::compile("é*x").find_match("ééx", 0), 0);
+
+	const auto not_quote = utf8_regex_matcher::compile("\"[^\"\\n]*\"");
+	const std::string text = "\"a ж € 😀\" tail";
+	EXPECT_EQ(not_quote.find_match(text, 0), text.find(" tail"));
+	EXPECT_EQ(not_quote.find_match("\"a\nb\"", 0), 0);
+
+	const auto mixed = utf8_regex_matcher::compile("[a-zа-я_]+");
+	EXPECT_EQ(mixed.find_match("имя_x1", 0), std::string("имя_x").size());
+
+	EXPECT_THROW(utf8_regex_matcher::compile("[a-"), std::runtime_error);
+	EXPECT_THROW(utf8_regex_matcher::compile("[z-a]"), std::runtime_error);
+	EXPECT_THROW(utf8_regex_matcher::compile("\xC3("), std::runtime_error);
+}
+
+TEST(Utf8Regex, LexerReportsCodePointColumns)
+{
+	const std::string source = "λ = «ωмега»\n  ж ?";
+
+	lexer<std::string, basic_fsm_regex_matcher<utf8_regex>> lex(source);
+	EXPECT_EQ(lex.columns(), column_unit::code_points);
+	lex.add_rule("[α-ωa-zа-я]+", "ID")
+		.add_rule("=", "EQ")
+		.add_rule("«[^»]*»", "STR")
+		.add_rule("( |\\n)+", "WS", true);
+
+	const auto tokens = lex.tokenize();
+	ASSERT_FALSE(tokens.has_value());
+	EXPECT_EQ(tokens.error().line, 2);
+	EXPECT_EQ(tokens.error().column, 5);
+
+	const std::string valid_source = source.substr(0, source.size() - 2);
+	lex.change_source(valid_source);
+	const auto valid = lex.tokenize();
+	ASSERT_TRUE(valid.has_value());
+	ASSERT_EQ(valid->size(), 4);
+	EXPECT_EQ((*valid)[2].type, "STR");
+	EXPECT_EQ((*valid)[2].column, 5);
+	EXPECT_EQ((*valid)[3].column, 3);
+	EXPECT_EQ((*valid)[3].position(lex.lines(), lex.columns()), (source_position{ 2, 3 }));
+
+	lexer<std::string, basic_fsm_regex_matcher<utf8_regex>> bytes(valid_source, lex.rules());
+	bytes.with_column_unit(column_unit::bytes);
+	const auto byte_tokens = bytes.tokenize();
+	ASSERT_TRUE(byte_tokens.has_value());
+	EXPECT_EQ((*byte_tokens)[2].column, 6);
+}
+
+basic_cfg<std::string> expression_grammar()
+{
+	return basic_cfg<std::string>(
+		{ "E'", "E", "T", "F" }, { "+", "*", "(", ")", "id" },
+		{ { "E'", { "E" } },
+			{ "E", { "E", "+", "T" } },
+			{ "E", { "T" } },
+			{ "T", { "T", "*", "F" } },
+			{ "T", { "F" } },
+			{ "F", { "(", "E", ")" } },
+			{ "F", { "id" } } },
+		"E'");
+}
+
+TEST(CompactTable, AgreesWithMapTable)
+{
+	const auto builder = lalr::table_builder(expression_grammar())
+							 .with_epsilon("ε")
+							 .with_end_marker("$")
+							 .with_augmented_start("E'");
+	const auto table = builder.build().value();
+	const auto compact = builder.build_compact().value();
+
+	const std::vector<std::string> terminals = { "+", "*", "(", ")", "id", "$", "unknown" };
+	const std::vector<std::string> non_terminals = { "E", "T", "F", "unknown" };
+
+	ASSERT_EQ(compact.state_count(), table.action_table().rbegin()->first + 1);
+	for (std::size_t state = 0; state <= compact.state_count(); ++state)
+	{
+		for (auto const& terminal : terminals)
+		{
+			auto const& expected = table.get_action(state, terminal);
+			auto const& actual = compact.get_action(state, terminal);
+			ASSERT_EQ(actual.index(), expected.index()) << state << " " << terminal;
+			if (const auto column = compact.terminal_index(terminal))
+			{
+				EXPECT_EQ(&compact.get_action(state, *column), &actual);
+			}
+			if (lr::actions::is_shift(expected))
+			{
+				EXPECT_EQ(lr::actions::as_shift(actual).target_state, lr::actions::as_shift(expected).target_state);
+			}
+			if (lr::actions::is_reduce(expected))
+			{
+				EXPECT_EQ(lr::actions::as_reduce(actual), lr::actions::as_reduce(expected));
+			}
+		}
+		for (auto const& non_terminal : non_terminals)
+		{
+			EXPECT_EQ(compact.get_goto(state, non_terminal), table.get_goto(state, non_terminal));
+		}
+		EXPECT_EQ(compact.expected_terminals(state), table.expected_terminals(state));
+	}
+
+	EXPECT_FALSE(compact.terminal_index("unknown").has_value());
+	EXPECT_LT(compact.packed_size(), compact.state_count() * (compact.terminals().size() + compact.non_terminals().size()));
+	EXPECT_LT(compact.actions().size(), 12 + 7 + 2);
+}
+
+TEST(CompactTable, ParsesLikeMapTable)
+{
+	const auto compact = slr::table_builder(expression_grammar())
+							 .with_epsilon("ε")
+							 .with_end_marker("$")
+							 .with_augmented_start("E'")
+							 .build_compact();
+	const auto table = slr::table_builder(expression_grammar())
+						   .with_epsilon("ε")
+						   .with_end_marker("$")
+						   .with_augmented_start("E'")
+						   .build();
+
+	for (std::vector<std::string> const& input : {
+			 std::vector<std::string>{ "id", "+", "id", "*", "(", "id", ")" },
+			 std::vector<std::string>{ "id", "+", "*", "id" },
+			 std::vector<std::string>{ "id", "+", "unknown" } })
+	{
+		lr::parser expected_parser(table, "ε");
+		lr::parser actual_parser(compact, "ε");
+		static_assert(std::is_same_v<decltype(actual_parser)::table_type, lr::compact_table<std::string>>);
+
+		std::vector<lr::parse_event<std::string>> expected;
+		for (auto const& event : expected_parser.parse(input))
+		{
+			expected.push_back(event);
+		}
+		std::vector<lr::parse_event<std::string>> actual;
+		for (auto const& event : actual_parser.parse(input))
+		{
+			actual.push_back(event);
+		}
+
+		ASSERT_EQ(actual.size(), expected.size());
+		for (std::size_t i = 0; i < actual.size(); ++i)
+		{
+			ASSERT_EQ(actual[i].index(), expected[i].index()) << i;
+			if (lr::events::is_reduce(expected[i]))
+			{
+				EXPECT_EQ(compact.rule(lr::events::as_reduce(actual[i]).rule_index), table.rule(lr::events::as_reduce(expected[i]).rule_index));
+			}
+			if (lr::events::is_error(expected[i]))
+			{
+				EXPECT_EQ(lr::events::as_error(actual[i]).expected_tokens, lr::events::as_error(expected[i]).expected_tokens);
+			}
+		}
+	}
+}
+
+TEST(LR0Item, PacksRuleIndexAndDot)
+{
+	const lr::lr0_item item{ 7, 2 };
+	EXPECT_EQ(item.rule_index(), 7);
+	EXPECT_EQ(item.dot(), 2);
+	EXPECT_EQ(item.advanced(), lr::lr0_item(7, 3));
+	EXPECT_EQ(sizeof(lr::lr0_item), 8);
+
+	// Dots order first, as kernels built by advancing a sorted closure stay sorted.
+	EXPECT_LT(lr::lr0_item(9, 1), lr::lr0_item(0, 2));
+	EXPECT_LT(lr::lr0_item(3, 1), lr::lr0_item(9, 1));
+}
+
+template <typename T_Builder>
+concept takes_thread_count = requires(T_Builder& builder) { builder.with_thread_count(2); };
+
+TEST(TableBuilder, ParallelBuildMatchesSingleThreaded)
+{
+	const auto lalr_builder = [](std::size_t thread_count) {
+		return lalr::table_builder(expression_grammar())
+			.with_epsilon("ε")
+			.with_end_marker("$")
+			.with_augmented_start("E'")
+			.with_thread_count(thread_count)
+			.build()
+			.value();
+	};
+	const auto slr_builder = [](std::size_t thread_count) {
+		return slr::table_builder(expression_grammar())
+			.with_epsilon("ε")
+			.with_end_marker("$")
+			.with_augmented_start("E'")
+			.with_thread_count(thread_count)
+			.build();
+	};
+
+	static_assert(takes_thread_count<lalr::table_builder<std::string>>);
+	static_assert(takes_thread_count<slr::table_builder<std::string>>);
+	static_assert(!takes_thread_count<lr1::table_builder<std::string>>);
+
+	const auto lalr_table = lalr_builder(1);
+	const auto slr_table = slr_builder(1);
+	ASSERT_GT(lalr_table.action_table().size(), 1);
+	for (const std::size_t thread_count : { 2, 4, 16 })
+	{
+		const auto parallel_lalr = lalr_builder(thread_count);
+		EXPECT_TRUE(parallel_lalr.action_table() == lalr_table.action_table()) << thread_count;
+		EXPECT_EQ(parallel_lalr.goto_table(), lalr_table.goto_table());
+
+		const auto parallel_slr = slr_builder(thread_count);
+		EXPECT_TRUE(parallel_slr.action_table() == slr_table.action_table()) << thread_count;
+		EXPECT_EQ(parallel_slr.goto_table(), slr_table.goto_table());
+	}
+}
+
+TEST(ParserRecords, MatchEventStream)
+{
+	static_assert(std::is_trivially_copyable_v<lr::event_record>);
+
+	const auto table = lalr::table_builder(expression_grammar())
+						   .with_epsilon("ε")
+						   .with_end_marker("$")
+						   .with_augmented_start("E'")
+						   .build()
+						   .value();
+
+	for (std::vector<std::string> const& input : {
+			 std::vector<std::string>{ "id", "*", "(", "id", "+", "id", ")" },
+			 std::vector<std::string>{ "(", "id", "+", ")" } })
+	{
+		lr::parser event_parser(table);
+		std::vector<lr::parse_event<std::string>> events;
+		for (auto const& event : event_parser.parse(input))
+		{
+			events.push_back(event);
+		}
+
+		lr::parser record_parser(table);
+		std::vector<lr::event_record> records;
+		for (auto record : record_parser.records(input))
+		{
+			records.push_back(record);
+		}
+
+		ASSERT_EQ(records.size(), events.size());
+		for (std::size_t i = 0; i < records.size(); ++i)
+		{
+			ASSERT_EQ(static_cast<std::size_t>(records[i].kind), events[i].index()) << i;
+			if (lr::events::is_shift(events[i]))
+			{
+				EXPECT_EQ(record_parser.token(records[i]), lr::events::as_shift(events[i]).token);
+			}
+			if (lr::events::is_reduce(events[i]))
+			{
+				EXPECT_EQ(records[i].rule_index, lr::events::as_reduce(events[i]).rule_index);
+				EXPECT_EQ(records[i].pop_count, lr::events::as_reduce(events[i]).pop_count);
+			}
+			if (lr::events::is_error(events[i]))
+			{
+				EXPECT_EQ(record_parser.token(records[i]), lr::events::as_error(events[i]).unexpected_token);
+				EXPECT_EQ(record_parser.expected_tokens(), lr::events::as_error(events[i]).expected_tokens);
+			}
+		}
+	}
+
+	lr::parser p(table);
+	std::vector<std::string> input = { "id", ")" };
+	p.begin(input);
+	std::optional<lr::event_record> last;
+	while (const auto record = p.next_record())
+	{
+		last = record;
+	}
+	ASSERT_TRUE(last.has_value());
+	EXPECT_EQ(last->kind, lr::event_kind::error);
+	EXPECT_EQ(last->token_index, 1);
+	EXPECT_EQ(p.expected_tokens(), (std::vector<std::string>{ "$", "+" }));
+}
+
+TEST(SemanticParser, UsesComparatorOfTable)
+{
+	using table_type = lr::table<char, std::greater<char>>;
+	table_type tbl;
+	tbl.set_end_marker('$');
+	tbl.add_action(0, 'a', lr::action_shift<std::size_t>{ 1 });
+	tbl.add_action(1, '$', tbl.make_reduce(cfg_rule{ 'S', { 'a' } }, 'e'));
+	tbl.add_goto(0, 'S', 2);
+	tbl.add_action(2, '$', lr::action_accept{});
+
+	lr::semantic_parser<int, table_type> evaluator(tbl);
+	evaluator.on_shift([](char, std::size_t) { return 7; });
+
+	const std::vector input = { 'a' };
+	EXPECT_EQ(evaluator.parse(input).value(), 7);
+	EXPECT_FALSE(evaluator.parse(std::vector{ 'b' }).has_value());
+}
+
+TEST(SemanticParser, EvaluatesExpressionsWithRuleCallbacks)
+{
+	const auto table = lalr::table_builder(expression_grammar())
+						   .with_epsilon("ε")
+						   .with_end_marker("$")
+						   .with_augmented_start("E'")
+						   .build()
+						   .value();
+
+	const std::vector<int> numbers = { 2, 0, 3, 0, 0, 4, 0, 5, 0 };
+	const std::vector<std::string> input = { "id", "*", "(", "+", "(", "id", "+", "id", ")", ")" };
+
+	lr::semantic_parser<int, lr::table<std::string>> evaluator(table);
+	evaluator
+		.on_shift([&](const std::string&, const std::size_t token_index) {
+			return numbers[token_index];
+		})
+		.on_reduce({ "E", { "E", "+", "T" } }, [](std::span<int> rhs) { return rhs[0] + rhs[2]; })
+		.on_reduce({ "T", { "T", "*", "F" } }, [](std::span<int> rhs) { return rhs[0] * rhs[2]; })
+		.on_reduce({ "F", { "(", "E", ")" } }, [](std::span<int> rhs) { return rhs[1]; });
+
+	const auto error = evaluator.parse(input);
+	ASSERT_FALSE(error.has_value());
+	EXPECT_EQ(error.error().unexpected_token, "+");
+	EXPECT_EQ(error.error().expected_tokens, (std::vector<std::string>{ "(", "id" }));
+
+	const std::vector<std::string> valid = { "id", "*", "(", "id", "+", "id", ")", "+", "id" };
+	const std::vector<int> valid_numbers = { 2, 0, 0, 3, 0, 4, 0, 0, 5 };
+	evaluator.on_shift([&](const std::string&, const std::size_t token_index) {
+		return valid_numbers[token_index];
+	});
+	const auto value = evaluator.parse(valid);
+	ASSERT_TRUE(value.has_value());
+	EXPECT_EQ(*value, 2 * (3 + 4) + 5);
+
+	EXPECT_THROW(evaluator.on_reduce({ "E", { "E", "-", "T" } }, [](std::span<int>) { return 0; }), std::invalid_argument);
+}
+
+TEST(AstBuilder, BuildsArenaTreeAndSkipsUnitRules)
+{
+	const auto table = lalr::table_builder(expression_grammar())
+						   .with_epsilon("ε")
+						   .with_end_marker("$")
+						   .with_augmented_start("E'")
+						   .build()
+						   .value();
+
+	const std::vector<std::string> input = { "id", "+", "id", "*", "id" };
+
+	const auto count_nodes = [](const auto& self, const lr::ast_node* node) -> std::size_t {
+		std::size_t count = 1;
+		for (const auto* child : node->children)
+		{
+			count += self(self, child);
+		}
+		return count;
+	};
+
+	lr::ast_builder full(table);
+	const auto full_tree = full.parse(input);
+	ASSERT_TRUE(full_tree.has_value());
+	// 5 leaves, 3 F -> id, 2 T -> F, E -> T, E -> E + T, T -> T * F.
+	EXPECT_EQ(count_nodes(count_nodes, *full_tree), 13);
+
+	lr::ast_builder skipping(table);
+	skipping.skip_unit_rules();
+	const auto* root = skipping.parse(input).value();
+	EXPECT_EQ(count_nodes(count_nodes, root), 10);
+
+	EXPECT_EQ(table.rule(root->rule_index), (cfg_rule<std::string>{ "E", { "E", "+", "T" } }));
+	ASSERT_EQ(root->children.size(), 3);
+	EXPECT_EQ(table.rule(root->children[0]->rule_index), (cfg_rule<std::string>{ "F", { "id" } }));
+	EXPECT_TRUE(root->children[1]->is_leaf());
+	EXPECT_EQ(root->children[1]->token_index, 1);
+	EXPECT_EQ(table.rule(root->children[2]->rule_index), (cfg_rule<std::string>{ "T", { "T", "*", "F" } }));
+	EXPECT_EQ(root->children[2]->token_index, 2);
+
+	const std::size_t bytes = skipping.bytes_used();
+	EXPECT_GT(bytes, 0);
+	ASSERT_TRUE(skipping.parse(input).has_value());
+	EXPECT_EQ(skipping.bytes_used(), bytes);
+
+	EXPECT_FALSE(skipping.parse(std::vector<std::string>{ "id", "id" }).has_value());
+}
@@ -0,0 +1,80 @@
+#include <fsm/lexer_spec.hpp>
+#include <fsm/scanner_generator.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+std::vector<fsm::scanner_rule> load_rules(std::istream& in)
+{
+	std::vector<fsm::scanner_rule> rules;
+	for (auto& entry : fsm::lexer_spec_parse(in))
+	{
+		rules.push_back({ std::move(entry.pattern), std::move(entry.name), entry.skip });
+	}
+
+	return rules;
+}
+} // namespace
+
+int main(const int argc, char* argv[])
+{
+	const auto usage = [&] {
+		std::cerr << "Usage: " << argv[0] << " <rules> <output.hpp> [--class NAME] [--namespace NAME]\n";
+		return 1;
+	};
+
+	if (argc < 3)
+	{
+		return usage();
+	}
+
+	fsm::scanner_options options;
+	for (int i = 3; i < argc; i += 2)
+	{
+		const std::string flag = argv[i];
+		if (flag != "--class" && flag != "--namespace")
+		{
+			std::cerr << "Unknown option: " << flag << "\n";
+			return 1;
+		}
+		if (i + 1 == argc)
+		{
+			std::cerr << "Missing value for " << flag << "\n";
+			return usage();
+		}
+
+		if (flag == "--class")
+		{
+			options.class_name = argv[i + 1];
+		}
+		else
+		{
+			options.namespace_name = argv[i + 1];
+		}
+	}
+
+	try
+	{
+		std::ifstream spec(argv[1]);
+		if (!spec.is_open())
+		{
+			throw std::runtime_error(std::string("Could not open file: ") + argv[1]);
+		}
+
+		std::ostringstream header;
+		fsm::generate_scanner(header, load_rules(spec), options);
+
+		std::ofstream out(argv[2]);
+		out << header.str();
+	}
+	catch (std::exception const& e)
+	{
+		std::cerr << e.what() << "\n";
+		return 1;
+	}
+
+	return 0;
+}